@@ -0,0 +1,70 @@
+#ifndef CLUSTER_PATHS_H
+#define CLUSTER_PATHS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "api\Vector2.h"
+#include "EncodedPath.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* ClusterPaths
+* Shortest paths between every pair of cells of a cluster. For every source cell, each cell reached from it
+* keeps the direction of its parent in the search tree of the source, one byte per pair of cells.
+* A path is read backward, from its goal to its source. The cells are numbered row by row inside the cluster.
+*/
+class ClusterPaths
+{
+	enum { M_NODIRECTION = 8 };
+
+private:
+	int m_MinX;
+	int m_MinY;
+	int m_Width;
+	unsigned m_NbCells;
+	std::vector<unsigned char> m_Directions;
+
+public:
+	ClusterPaths(const int in_MinX, const int in_MinY, const int in_Length, const int in_Width) :
+		m_MinX(in_MinX), m_MinY(in_MinY), m_Width(in_Width), m_NbCells(in_Length * in_Width),
+		m_Directions(m_NbCells * m_NbCells, static_cast<unsigned char>(M_NODIRECTION)) { }
+
+	static std::size_t Bytes(const int in_Length, const int in_Width)
+	{
+		return static_cast<std::size_t>(in_Length * in_Width) * (in_Length * in_Width);
+	}
+
+	// The parent must be one of the eight neighbors of the cell
+	void SetParent(const unsigned in_Source, const unsigned in_Cell, const unsigned in_Parent)
+	{
+		m_Directions[in_Source * m_NbCells + in_Cell] = static_cast<unsigned char>(EncodedPath::Direction(
+			static_cast<int>(in_Parent % m_Width) - static_cast<int>(in_Cell % m_Width),
+			static_cast<int>(in_Parent / m_Width) - static_cast<int>(in_Cell / m_Width)));
+	}
+
+	// Appends the cells of the path from in_Start to in_Goal to out_Path. Returns false when there is no such path.
+	bool Decode(const unsigned in_Start, const unsigned in_Goal, std::vector<Vector2> & out_Path) const
+	{
+		const unsigned char * l_Directions = &m_Directions[in_Start * m_NbCells];
+		if(in_Start == in_Goal || l_Directions[in_Goal] == M_NODIRECTION)
+			return false;
+
+		const std::size_t l_First = out_Path.size();
+		int l_X = in_Goal % m_Width, l_Y = in_Goal / m_Width;
+		for(unsigned l_Cell = in_Goal; l_Cell != in_Start; l_Cell = l_X + l_Y * m_Width)
+		{
+			out_Path.push_back(Vector2(static_cast<float>(m_MinX + l_X), static_cast<float>(m_MinY + l_Y)));
+			l_X += EncodedPath::DeltaX(l_Directions[l_Cell]);
+			l_Y += EncodedPath::DeltaY(l_Directions[l_Cell]);
+		}
+		out_Path.push_back(Vector2(static_cast<float>(m_MinX + l_X), static_cast<float>(m_MinY + l_Y)));
+		std::reverse(out_Path.begin() + l_First, out_Path.end());
+		return true;
+	}
+};
+
+#endif // CLUSTER_PATHS_H
@@ -0,0 +1,122 @@
+#ifndef COMPACT_GRAPH_H
+#define COMPACT_GRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* CompactGraph
+* Frozen adjacency lists in compressed sparse row format. The edges leaving node n are
+* at [Begin(n), End(n)[ in the target and cost arrays.
+* A small overlay holds the edges added after the graph was frozen (e.g. the edges linking
+* the start and the goal of a query to the border of their cluster).
+*/
+class CompactGraph
+{
+public:
+	typedef std::uint32_t NodeId;
+
+	struct OverlayEdge
+	{
+		NodeId From;
+		NodeId To;
+		double Cost;
+	};
+
+	typedef std::vector<OverlayEdge>::const_iterator OverlayIterator;
+
+private:
+	struct OverlayComparer
+	{
+		bool operator()(const OverlayEdge & in_Edge1, const OverlayEdge & in_Edge2) const { return in_Edge1.From < in_Edge2.From; }
+	};
+
+private:
+	std::vector<unsigned> m_Offsets;
+	std::vector<NodeId> m_Targets;
+	std::vector<double> m_Costs;
+	// Sorted by source node
+	std::vector<OverlayEdge> m_Overlay;
+
+public:
+	CompactGraph() : m_Offsets(1, 0) { }
+
+	// Freezes a graph whose nodes are in [0, in_NbNodes[
+	void Build(const std::map<NodeId, std::map<NodeId, double>> & in_Graph, const unsigned in_NbNodes)
+	{
+		m_Offsets.assign(in_NbNodes + 1, 0);
+		for(auto l_It = in_Graph.begin(); l_It != in_Graph.end(); ++l_It)
+			m_Offsets[l_It->first + 1] = static_cast<unsigned>(l_It->second.size());
+		for(unsigned i = 0; i < in_NbNodes; ++i)
+			m_Offsets[i + 1] += m_Offsets[i];
+
+		m_Targets.resize(m_Offsets.back());
+		m_Costs.resize(m_Offsets.back());
+		for(auto l_It = in_Graph.begin(); l_It != in_Graph.end(); ++l_It)
+		{
+			unsigned l_Edge = m_Offsets[l_It->first];
+			for(auto l_EdgeIt = l_It->second.begin(); l_EdgeIt != l_It->second.end(); ++l_EdgeIt, ++l_Edge)
+			{
+				m_Targets[l_Edge] = l_EdgeIt->first;
+				m_Costs[l_Edge] = l_EdgeIt->second;
+			}
+		}
+		m_Overlay.clear();
+	}
+
+	// Replaces the frozen graph by arrays saved from another one, the arguments are left empty
+	void Assign(std::vector<unsigned> & io_Offsets, std::vector<NodeId> & io_Targets, std::vector<double> & io_Costs)
+	{
+		m_Offsets.swap(io_Offsets);
+		m_Targets.swap(io_Targets);
+		m_Costs.swap(io_Costs);
+		io_Offsets.clear();
+		io_Targets.clear();
+		io_Costs.clear();
+		m_Overlay.clear();
+	}
+
+	void Clear()
+	{
+		m_Offsets.assign(1, 0);
+		m_Targets.clear();
+		m_Costs.clear();
+		m_Overlay.clear();
+	}
+
+	const std::vector<unsigned> & Offsets() const { return m_Offsets; }
+	const std::vector<NodeId> & Targets() const { return m_Targets; }
+	const std::vector<double> & Costs() const { return m_Costs; }
+
+	unsigned NbNodes() const { return static_cast<unsigned>(m_Offsets.size() - 1); }
+	unsigned NbEdges() const { return static_cast<unsigned>(m_Targets.size()); }
+
+	// Nodes created after the graph was frozen have no frozen edges
+	unsigned Begin(const NodeId in_Node) const { return in_Node < NbNodes() ? m_Offsets[in_Node] : 0; }
+	unsigned End(const NodeId in_Node) const { return in_Node < NbNodes() ? m_Offsets[in_Node + 1] : 0; }
+	NodeId Target(const unsigned in_Edge) const { return m_Targets[in_Edge]; }
+	double Cost(const unsigned in_Edge) const { return m_Costs[in_Edge]; }
+
+	void AddOverlayEdge(const NodeId in_From, const NodeId in_To, const double in_Cost)
+	{
+		OverlayEdge l_Edge = { in_From, in_To, in_Cost };
+		m_Overlay.insert(std::upper_bound(m_Overlay.begin(), m_Overlay.end(), l_Edge, OverlayComparer()), l_Edge);
+	}
+
+	void ClearOverlay() { m_Overlay.clear(); }
+	bool HasOverlay() const { return !m_Overlay.empty(); }
+
+	std::pair<OverlayIterator, OverlayIterator> OverlayEdges(const NodeId in_Node) const
+	{
+		OverlayEdge l_Key = { in_Node, 0, 0.0 };
+		return std::equal_range(m_Overlay.begin(), m_Overlay.end(), l_Key, OverlayComparer());
+	}
+};
+
+#endif // COMPACT_GRAPH_H
@@ -0,0 +1,121 @@
+#ifndef ENCODED_PATH_H
+#define ENCODED_PATH_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "api\Vector2.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* EncodedPath
+* Path on an 8-connected grid stored as its two ends and a 3-bit direction per step,
+* 21 steps to a 64-bit word. The directions go around the cell so the opposite of d is d ^ 4.
+*/
+class EncodedPath
+{
+	enum { M_BITSPERSTEP = 3, M_STEPSPERWORD = 21 };
+
+private:
+	unsigned short m_StartX;
+	unsigned short m_StartY;
+	unsigned short m_GoalX;
+	unsigned short m_GoalY;
+	unsigned m_NbSteps;
+	std::vector<std::uint64_t> m_Words;
+
+public:
+	EncodedPath(const int in_StartX = 0, const int in_StartY = 0) :
+		m_StartX(static_cast<unsigned short>(in_StartX)), m_StartY(static_cast<unsigned short>(in_StartY)),
+		m_GoalX(static_cast<unsigned short>(in_StartX)), m_GoalY(static_cast<unsigned short>(in_StartY)), m_NbSteps(0) { }
+
+	// Moves the end of the path to one of the eight neighbors of the current end
+	void Append(const int in_X, const int in_Y)
+	{
+		const unsigned l_Direction = Direction(in_X - m_GoalX, in_Y - m_GoalY);
+		if(m_NbSteps % M_STEPSPERWORD == 0)
+			m_Words.push_back(0);
+		m_Words.back() |= std::uint64_t(l_Direction) << (m_NbSteps % M_STEPSPERWORD * M_BITSPERSTEP);
+
+		m_GoalX = static_cast<unsigned short>(in_X);
+		m_GoalY = static_cast<unsigned short>(in_Y);
+		++m_NbSteps;
+	}
+
+	void Reserve(const unsigned in_NbSteps)
+	{
+		m_Words.reserve((in_NbSteps + M_STEPSPERWORD - 1) / M_STEPSPERWORD);
+	}
+
+	unsigned NbSteps() const { return m_NbSteps; }
+	std::size_t Bytes() const { return m_Words.capacity() * sizeof(std::uint64_t); }
+
+	// Appends the cells of the path to out_Path, from the goal to the start when in_Reversed is true
+	void Decode(const bool in_Reversed, std::vector<Vector2> & out_Path) const
+	{
+		out_Path.reserve(out_Path.size() + m_NbSteps + 1);
+
+		if(!in_Reversed)
+		{
+			int l_X = m_StartX, l_Y = m_StartY;
+			out_Path.push_back(Vector2(static_cast<float>(l_X), static_cast<float>(l_Y)));
+			for(unsigned i = 0; i < m_NbSteps; ++i)
+			{
+				const unsigned l_Direction = Step(i);
+				l_X += DeltaX(l_Direction);
+				l_Y += DeltaY(l_Direction);
+				out_Path.push_back(Vector2(static_cast<float>(l_X), static_cast<float>(l_Y)));
+			}
+		}
+		else
+		{
+			int l_X = m_GoalX, l_Y = m_GoalY;
+			out_Path.push_back(Vector2(static_cast<float>(l_X), static_cast<float>(l_Y)));
+			for(unsigned i = m_NbSteps; i > 0; --i)
+			{
+				const unsigned l_Direction = Step(i - 1) ^ 4;
+				l_X += DeltaX(l_Direction);
+				l_Y += DeltaY(l_Direction);
+				out_Path.push_back(Vector2(static_cast<float>(l_X), static_cast<float>(l_Y)));
+			}
+		}
+	}
+
+	// 0 goes toward +x and every following direction turns 45 degrees toward +y
+	static unsigned Direction(const int in_DeltaX, const int in_DeltaY)
+	{
+		static const unsigned l_Directions[3][3] = { { 5, 4, 3 }, { 6, 8, 2 }, { 7, 0, 1 } };
+		assert(in_DeltaX >= -1 && in_DeltaX <= 1 && in_DeltaY >= -1 && in_DeltaY <= 1);
+		assert(in_DeltaX || in_DeltaY);
+		return l_Directions[in_DeltaX + 1][in_DeltaY + 1];
+	}
+
+	static int DeltaX(const unsigned in_Direction)
+	{
+		static const int l_DeltaX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		return l_DeltaX[in_Direction];
+	}
+
+	static int DeltaY(const unsigned in_Direction)
+	{
+		static const int l_DeltaY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+		return l_DeltaY[in_Direction];
+	}
+
+private:
+	unsigned Step(const unsigned in_Step) const
+	{
+		return static_cast<unsigned>(m_Words[in_Step / M_STEPSPERWORD] >> (in_Step % M_STEPSPERWORD * M_BITSPERSTEP)) & 7;
+	}
+};
+
+inline std::size_t PathBytes(const EncodedPath & in_Path)
+{
+	return in_Path.Bytes();
+}
+
+#endif // ENCODED_PATH_H
@@ -0,0 +1,136 @@
+#ifndef FIXED_CLUSTER_SEARCH_H
+#define FIXED_CLUSTER_SEARCH_H
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "GridGraph.h"
+#include "IndexedHeap.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* FixedClusterSearch
+* Dijkstra restricted to one cluster of the base level, specialised at compile time on the largest cluster it holds
+* and on the connectivity of the grid. The cluster is copied in a square of side MaxSize + 2 whose border is blocked,
+* so the offsets of the neighbors are constants and the search never checks a bound. The cells are numbered row by row
+* inside the cluster. With diagonals, the costs and the ties are the ones of the searches on the GridGraph.
+*/
+template<int MaxSize, bool Diagonals>
+class FixedClusterSearch
+{
+public:
+	static const unsigned M_NOPARENT = 0xFFFFFFFF;
+
+private:
+	enum { M_STRIDE = MaxSize + 2, M_NBSLOTS = M_STRIDE * M_STRIDE };
+
+private:
+	int m_Width;
+	unsigned m_Expansions;
+	bool m_Walkable[M_NBSLOTS];
+	bool m_Closed[M_NBSLOTS];
+	double m_Costs[M_NBSLOTS];
+	unsigned m_Parents[M_NBSLOTS];
+	IndexedHeap<double> m_Opened;
+
+public:
+	FixedClusterSearch() : m_Width(1), m_Expansions(0), m_Opened(M_NBSLOTS)
+	{
+		std::fill(m_Walkable, m_Walkable + M_NBSLOTS, false);
+		std::fill(m_Closed, m_Closed + M_NBSLOTS, false);
+	}
+
+	static bool Fits(const int in_Length, const int in_Width)
+	{
+		return in_Length <= MaxSize && in_Width <= MaxSize;
+	}
+
+	// The cluster's bounds are its top left cell and its size, the cells around it stay blocked
+	void Load(const GridGraph & in_Grid, const int in_MinX, const int in_MinY, const int in_Length, const int in_Width)
+	{
+		assert(Fits(in_Length, in_Width));
+		m_Width = in_Width;
+		std::fill(m_Walkable, m_Walkable + M_NBSLOTS, false);
+		for(int y = 0; y < in_Length; ++y)
+			for(int x = 0; x < in_Width; ++x)
+				m_Walkable[(y + 1) * M_STRIDE + x + 1] = in_Grid.Walkable(in_MinX + x, in_MinY + y);
+	}
+
+	// Computes the distance from the cell to every cell of the cluster it can reach. Returns false when the cell is blocked.
+	bool Run(const unsigned in_Source)
+	{
+		const unsigned l_Source = Slot(in_Source);
+		m_Expansions = 0;
+		if(!m_Walkable[l_Source])
+			return false;
+
+		std::fill(m_Closed, m_Closed + M_NBSLOTS, false);
+		std::fill(m_Costs, m_Costs + M_NBSLOTS, std::numeric_limits<double>::infinity());
+		m_Costs[l_Source] = 0.0;
+		m_Parents[l_Source] = M_NOPARENT;
+		m_Opened.Push(l_Source, 0.0);
+
+		while(!m_Opened.Empty())
+		{
+			const unsigned l_Current = m_Opened.Pop();
+			m_Closed[l_Current] = true;
+			++m_Expansions;
+			Expand(l_Current);
+		}
+		return true;
+	}
+
+	unsigned Expansions() const { return m_Expansions; }
+
+	// The results of the last search
+	bool Reached(const unsigned in_Cell) const { return m_Closed[Slot(in_Cell)]; }
+	double Cost(const unsigned in_Cell) const { return m_Costs[Slot(in_Cell)]; }
+
+	unsigned Parent(const unsigned in_Cell) const
+	{
+		const unsigned l_Parent = m_Parents[Slot(in_Cell)];
+		return l_Parent == M_NOPARENT ? M_NOPARENT : (l_Parent / M_STRIDE - 1) * m_Width + l_Parent % M_STRIDE - 1;
+	}
+
+private:
+	unsigned Slot(const unsigned in_Cell) const
+	{
+		return (in_Cell / m_Width + 1) * M_STRIDE + in_Cell % m_Width + 1;
+	}
+
+	// The neighbors are relaxed in increasing order, like GridGraph::ForEachNeighbor
+	void Expand(const unsigned in_Slot)
+	{
+		if(Diagonals)
+			Relax(in_Slot, in_Slot - M_STRIDE - 1, 1.42);
+		Relax(in_Slot, in_Slot - M_STRIDE, 1.0);
+		if(Diagonals)
+			Relax(in_Slot, in_Slot - M_STRIDE + 1, 1.42);
+		Relax(in_Slot, in_Slot - 1, 1.0);
+		Relax(in_Slot, in_Slot + 1, 1.0);
+		if(Diagonals)
+			Relax(in_Slot, in_Slot + M_STRIDE - 1, 1.42);
+		Relax(in_Slot, in_Slot + M_STRIDE, 1.0);
+		if(Diagonals)
+			Relax(in_Slot, in_Slot + M_STRIDE + 1, 1.42);
+	}
+
+	void Relax(const unsigned in_Slot, const unsigned in_Neighbor, const double in_Cost)
+	{
+		if(!m_Walkable[in_Neighbor] || m_Closed[in_Neighbor])
+			return;
+
+		const double l_Cost = m_Costs[in_Slot] + in_Cost;
+		if(l_Cost >= m_Costs[in_Neighbor])
+			return;
+
+		m_Costs[in_Neighbor] = l_Cost;
+		m_Parents[in_Neighbor] = in_Slot;
+		m_Opened.Push(in_Neighbor, l_Cost);
+	}
+};
+
+#endif // FIXED_CLUSTER_SEARCH_H
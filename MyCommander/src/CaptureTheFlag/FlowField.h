@@ -0,0 +1,73 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <limits>
+#include <vector>
+
+#include "api\Vector2.h"
+#include "EncodedPath.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* FlowField
+* Shortest paths from every cell of the map to a single goal. Each cell reached from the goal keeps its distance
+* to it and the direction of the next cell on its way there, one byte per cell. A path is read by following the
+* directions from its start, there is no search. The cells are numbered row by row.
+*/
+class FlowField
+{
+	enum { M_NODIRECTION = 8 };
+
+private:
+	unsigned m_Goal;
+	int m_Width;
+	std::vector<float> m_Distances;
+	std::vector<unsigned char> m_Directions;
+
+public:
+	FlowField(const unsigned in_Goal, const int in_Length, const int in_Width) :
+		m_Goal(in_Goal), m_Width(in_Width), m_Distances(in_Length * in_Width, std::numeric_limits<float>::infinity()),
+		m_Directions(in_Length * in_Width, static_cast<unsigned char>(M_NODIRECTION)) { }
+
+	unsigned Goal() const { return m_Goal; }
+
+	// The next cell must be one of the eight neighbors of the cell
+	void SetStep(const unsigned in_Cell, const unsigned in_Next, const double in_Distance)
+	{
+		m_Distances[in_Cell] = static_cast<float>(in_Distance);
+		m_Directions[in_Cell] = static_cast<unsigned char>(EncodedPath::Direction(
+			static_cast<int>(in_Next % m_Width) - static_cast<int>(in_Cell % m_Width),
+			static_cast<int>(in_Next / m_Width) - static_cast<int>(in_Cell / m_Width)));
+	}
+
+	void SetGoalReached() { m_Distances[m_Goal] = 0.f; }
+
+	bool Reached(const unsigned in_Cell) const { return m_Distances[in_Cell] < std::numeric_limits<float>::infinity(); }
+	float Distance(const unsigned in_Cell) const { return m_Distances[in_Cell]; }
+
+	// Next cell toward the goal, the goal itself once there. The cell must be reached.
+	unsigned Next(const unsigned in_Cell) const
+	{
+		if(in_Cell == m_Goal)
+			return in_Cell;
+		return in_Cell + EncodedPath::DeltaX(m_Directions[in_Cell]) + EncodedPath::DeltaY(m_Directions[in_Cell]) * m_Width;
+	}
+
+	// Appends the cells of the path from in_Start to the goal to out_Path. Returns false when the goal cannot be reached.
+	bool Descend(const unsigned in_Start, std::vector<Vector2> & out_Path) const
+	{
+		if(!Reached(in_Start))
+			return false;
+
+		for(unsigned l_Cell = in_Start; ; l_Cell = Next(l_Cell))
+		{
+			out_Path.push_back(Vector2(static_cast<float>(l_Cell % m_Width), static_cast<float>(l_Cell / m_Width)));
+			if(l_Cell == m_Goal)
+				return true;
+		}
+	}
+};
+
+#endif // FLOW_FIELD_H
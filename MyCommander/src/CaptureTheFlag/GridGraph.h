@@ -0,0 +1,297 @@
+#ifndef GRID_GRAPH_H
+#define GRID_GRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* GridGraph
+* Implicit graph of the base level. Only the passability of the cells is stored, one bit per cell
+* with the rows packed in 64-bit words. The edges are generated during the search: a walkable cell
+* is linked to its eight walkable neighbors, straight moves cost 1 and diagonal moves cost 1.42.
+* The grid can also be searched with jump point search (Harabor & Grastien, 2011): the successors
+* of a node are then the jump points found in the directions left after pruning.
+* The connected components of a part of the grid are labelled in two passes with a union-find.
+*/
+class GridGraph
+{
+public:
+	typedef std::uint32_t NodeId;
+
+	static const unsigned M_NOCOMPONENT = 0xFFFFFFFF;
+
+	// Part of the grid a search is allowed to visit, bounds included
+	struct Window
+	{
+		const GridGraph * Grid;
+		int MinX;
+		int MinY;
+		int MaxX;
+		int MaxY;
+
+		Window(const GridGraph & in_Grid, const int in_MinX, const int in_MinY, const int in_MaxX, const int in_MaxY) :
+			Grid(&in_Grid), MinX(in_MinX), MinY(in_MinY), MaxX(in_MaxX), MaxY(in_MaxY) { }
+	};
+
+	// Window searched with jump point search, the jumps stop on the goal
+	struct JumpWindow : public Window
+	{
+		NodeId Goal;
+
+		JumpWindow(const Window & in_Window, const NodeId in_Goal) : Window(in_Window), Goal(in_Goal) { }
+	};
+
+private:
+	static const NodeId M_NOJUMP = 0xFFFFFFFF;
+
+private:
+	int m_Length;
+	int m_Width;
+	unsigned m_WordsPerRow;
+	std::vector<std::uint64_t> m_Words;
+
+public:
+	GridGraph() : m_Length(0), m_Width(0), m_WordsPerRow(0) { }
+
+	// A cell is walkable when it has no block on it
+	void Build(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width)
+	{
+		m_Length = in_Length;
+		m_Width = in_Width;
+		m_WordsPerRow = (in_Width + 63) / 64;
+		m_Words.assign(m_WordsPerRow * in_Length, 0);
+
+		for(int y = 0; y < in_Length; ++y)
+			for(int x = 0; x < in_Width; ++x)
+				if(!in_Level[x + y * in_Width])
+					m_Words[y * m_WordsPerRow + x / 64] |= std::uint64_t(1) << (x % 64);
+	}
+
+	void Clear()
+	{
+		m_Length = m_Width = 0;
+		m_WordsPerRow = 0;
+		m_Words.clear();
+	}
+
+	int Length() const { return m_Length; }
+	int Width() const { return m_Width; }
+	// The rows are packed in the words from the first cell, bit x % 64 of word x / 64. The bits past the last cell are blocked.
+	unsigned WordsPerRow() const { return m_WordsPerRow; }
+	std::uint64_t Word(const unsigned in_Index) const { return m_Words[in_Index]; }
+	Window Whole() const { return Window(*this, 0, 0, m_Width - 1, m_Length - 1); }
+
+	bool Walkable(const int in_X, const int in_Y) const
+	{
+		return (m_Words[in_Y * m_WordsPerRow + in_X / 64] >> (in_X % 64)) & 1;
+	}
+
+	// Numbers the components of the walkable cells inside the window from 0, in the order of their first cell. The labels are
+	// written at the index of the cells in io_Labels, which holds the whole grid, the blocked cells get M_NOCOMPONENT.
+	// The cells are linked like in the searches. Returns the number of components.
+	unsigned LabelComponents(const Window & in_Window, std::vector<unsigned> & io_Labels) const
+	{
+		// The neighbors already labelled: left and the three above
+		static const int l_DX[] = { -1, -1, 0, 1 };
+		static const int l_DY[] = { 0, -1, -1, -1 };
+
+		std::vector<unsigned> l_Parents;
+		for(int y = in_Window.MinY; y <= in_Window.MaxY; ++y)
+		{
+			for(int x = in_Window.MinX; x <= in_Window.MaxX; ++x)
+			{
+				unsigned l_Label = M_NOCOMPONENT;
+				for(int i = 0; i < 4 && Walkable(x, y); ++i)
+				{
+					if(!Free(x + l_DX[i], y + l_DY[i], in_Window))
+						continue;
+
+					const unsigned l_Root = FindRoot(l_Parents, io_Labels[(x + l_DX[i]) + (y + l_DY[i]) * m_Width]);
+					if(l_Label == M_NOCOMPONENT)
+						l_Label = l_Root;
+					else if(l_Root != l_Label)
+					{
+						l_Parents[std::max(l_Root, l_Label)] = std::min(l_Root, l_Label);
+						l_Label = std::min(l_Root, l_Label);
+					}
+				}
+
+				if(l_Label == M_NOCOMPONENT && Walkable(x, y))
+				{
+					l_Label = static_cast<unsigned>(l_Parents.size());
+					l_Parents.push_back(l_Label);
+				}
+				io_Labels[x + y * m_Width] = l_Label;
+			}
+		}
+
+		// The roots are numbered in the order they are met
+		std::vector<unsigned> l_Numbers(l_Parents.size(), static_cast<unsigned>(M_NOCOMPONENT));
+		unsigned l_NbComponents = 0;
+		for(int y = in_Window.MinY; y <= in_Window.MaxY; ++y)
+		{
+			for(int x = in_Window.MinX; x <= in_Window.MaxX; ++x)
+			{
+				unsigned & l_Label = io_Labels[x + y * m_Width];
+				if(l_Label == M_NOCOMPONENT)
+					continue;
+
+				const unsigned l_Root = FindRoot(l_Parents, l_Label);
+				if(l_Numbers[l_Root] == M_NOCOMPONENT)
+					l_Numbers[l_Root] = l_NbComponents++;
+				l_Label = l_Numbers[l_Root];
+			}
+		}
+		return l_NbComponents;
+	}
+
+	// Calls in_Visitor(neighbor, cost) for every walkable neighbor of the node inside the window.
+	// The neighbors are visited in increasing node order.
+	template<class Visitor>
+	void ForEachNeighbor(const NodeId in_Node, const Window & in_Window, Visitor & in_Visitor) const
+	{
+		const int l_X = in_Node % m_Width;
+		const int l_Y = in_Node / m_Width;
+
+		for(int l_NeighborY = l_Y - 1; l_NeighborY <= l_Y + 1; ++l_NeighborY)
+		{
+			if(l_NeighborY < in_Window.MinY || l_NeighborY > in_Window.MaxY)
+				continue;
+
+			for(int l_NeighborX = l_X - 1; l_NeighborX <= l_X + 1; ++l_NeighborX)
+			{
+				if(l_NeighborX < in_Window.MinX || l_NeighborX > in_Window.MaxX
+					|| (l_NeighborX == l_X && l_NeighborY == l_Y) || !Walkable(l_NeighborX, l_NeighborY))
+					continue;
+
+				in_Visitor(static_cast<NodeId>(l_NeighborX + l_NeighborY * m_Width),
+					l_NeighborX == l_X || l_NeighborY == l_Y ? 1.0 : 1.42);
+			}
+		}
+	}
+
+	// Calls in_Visitor(jump point, cost) for every jump point reachable from the node. The direction the node
+	// was reached from is given by its parent, every direction is searched when the parent is not a cell of the grid.
+	template<class Visitor>
+	void ForEachJumpPoint(const NodeId in_Node, const NodeId in_Parent, const JumpWindow & in_Window, Visitor & in_Visitor) const
+	{
+		const int l_X = in_Node % m_Width;
+		const int l_Y = in_Node / m_Width;
+
+		if(in_Parent >= static_cast<NodeId>(m_Length * m_Width))
+		{
+			for(int l_DY = -1; l_DY <= 1; ++l_DY)
+				for(int l_DX = -1; l_DX <= 1; ++l_DX)
+					if(l_DX || l_DY)
+						VisitJump(l_X, l_Y, l_DX, l_DY, in_Window, in_Visitor);
+			return;
+		}
+
+		const int l_DX = Sign(l_X - static_cast<int>(in_Parent % m_Width));
+		const int l_DY = Sign(l_Y - static_cast<int>(in_Parent / m_Width));
+
+		if(l_DX && l_DY)
+		{
+			VisitJump(l_X, l_Y, l_DX, 0, in_Window, in_Visitor);
+			VisitJump(l_X, l_Y, 0, l_DY, in_Window, in_Visitor);
+			VisitJump(l_X, l_Y, l_DX, l_DY, in_Window, in_Visitor);
+			if(!Free(l_X - l_DX, l_Y, in_Window))
+				VisitJump(l_X, l_Y, -l_DX, l_DY, in_Window, in_Visitor);
+			if(!Free(l_X, l_Y - l_DY, in_Window))
+				VisitJump(l_X, l_Y, l_DX, -l_DY, in_Window, in_Visitor);
+		}
+		else if(l_DX)
+		{
+			VisitJump(l_X, l_Y, l_DX, 0, in_Window, in_Visitor);
+			if(!Free(l_X, l_Y + 1, in_Window))
+				VisitJump(l_X, l_Y, l_DX, 1, in_Window, in_Visitor);
+			if(!Free(l_X, l_Y - 1, in_Window))
+				VisitJump(l_X, l_Y, l_DX, -1, in_Window, in_Visitor);
+		}
+		else
+		{
+			VisitJump(l_X, l_Y, 0, l_DY, in_Window, in_Visitor);
+			if(!Free(l_X + 1, l_Y, in_Window))
+				VisitJump(l_X, l_Y, 1, l_DY, in_Window, in_Visitor);
+			if(!Free(l_X - 1, l_Y, in_Window))
+				VisitJump(l_X, l_Y, -1, l_DY, in_Window, in_Visitor);
+		}
+	}
+
+private:
+	static int Sign(const int in_Value) { return (in_Value > 0) - (in_Value < 0); }
+
+	// Halves the path to the root on the way
+	static unsigned FindRoot(std::vector<unsigned> & io_Parents, unsigned in_Label)
+	{
+		while(io_Parents[in_Label] != in_Label)
+		{
+			io_Parents[in_Label] = io_Parents[io_Parents[in_Label]];
+			in_Label = io_Parents[in_Label];
+		}
+		return in_Label;
+	}
+
+	bool Free(const int in_X, const int in_Y, const Window & in_Window) const
+	{
+		return in_X >= in_Window.MinX && in_X <= in_Window.MaxX && in_Y >= in_Window.MinY && in_Y <= in_Window.MaxY
+			&& Walkable(in_X, in_Y);
+	}
+
+	template<class Visitor>
+	void VisitJump(const int in_X, const int in_Y, const int in_DX, const int in_DY, const JumpWindow & in_Window, Visitor & in_Visitor) const
+	{
+		const NodeId l_Jump = Jump(in_X, in_Y, in_DX, in_DY, in_Window);
+		if(l_Jump == M_NOJUMP)
+			return;
+
+		// Jumps follow a straight or a diagonal line
+		const int l_Steps = std::max(std::abs(static_cast<int>(l_Jump % m_Width) - in_X), std::abs(static_cast<int>(l_Jump / m_Width) - in_Y));
+		in_Visitor(l_Jump, l_Steps * (in_DX && in_DY ? 1.42 : 1.0));
+	}
+
+	// Moves from a cell in one direction until a cell with a forced neighbor or the goal is found.
+	// Diagonal jumps also stop on the cells from which a straight jump finds something.
+	NodeId Jump(int in_X, int in_Y, const int in_DX, const int in_DY, const JumpWindow & in_Window) const
+	{
+		while(true)
+		{
+			in_X += in_DX;
+			in_Y += in_DY;
+			if(!Free(in_X, in_Y, in_Window))
+				return M_NOJUMP;
+
+			const NodeId l_Node = static_cast<NodeId>(in_X + in_Y * m_Width);
+			if(l_Node == in_Window.Goal)
+				return l_Node;
+
+			if(in_DX && in_DY)
+			{
+				if((Free(in_X - in_DX, in_Y + in_DY, in_Window) && !Free(in_X - in_DX, in_Y, in_Window))
+					|| (Free(in_X + in_DX, in_Y - in_DY, in_Window) && !Free(in_X, in_Y - in_DY, in_Window))
+					|| Jump(in_X, in_Y, in_DX, 0, in_Window) != M_NOJUMP || Jump(in_X, in_Y, 0, in_DY, in_Window) != M_NOJUMP)
+					return l_Node;
+			}
+			else if(in_DX)
+			{
+				if((Free(in_X + in_DX, in_Y + 1, in_Window) && !Free(in_X, in_Y + 1, in_Window))
+					|| (Free(in_X + in_DX, in_Y - 1, in_Window) && !Free(in_X, in_Y - 1, in_Window)))
+					return l_Node;
+			}
+			else
+			{
+				if((Free(in_X + 1, in_Y + in_DY, in_Window) && !Free(in_X + 1, in_Y, in_Window))
+					|| (Free(in_X - 1, in_Y + in_DY, in_Window) && !Free(in_X - 1, in_Y, in_Window)))
+					return l_Node;
+			}
+		}
+	}
+};
+
+#endif // GRID_GRAPH_H
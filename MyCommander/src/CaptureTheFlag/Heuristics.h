@@ -1,44 +1,119 @@
-#ifndef IHEURISTIC_H
-#define IHEURISTIC_H
+#ifndef HEURISTICS_H
+#define HEURISTICS_H
 
-#include "Navigator.h"
+#include <algorithm>
+#include <cmath>
+
+#include "api\Vector2.h"
+#include "Landmarks.h"
 
 /*
 * Author : Felix-Antoine Ouellet
 * CIP :	   09 137 551
+*
+* Heuristics
+* Policies of the searches of the Navigator, which takes them as a template parameter so that the estimate
+* is inlined in the relaxation of every neighbor. A policy is a copyable class with
+* double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
+* that returns a lower bound of the cost from in_Start to in_Goal.
 */
 
-class IHeuristic
+class TrivialHeuristic
 {
 public:
-	virtual double operator()(const Navigator::Node & in_Start, const Navigator::Node & in_Goal) const = 0;
+	double operator()(const Vector2 &, const Vector2 &) const
+	{
+		return 0.0;
+	}
 };
 
-class TrivialHeuristic : public IHeuristic
+class EuclideanDistance
 {
 public:
-	double operator()(const Navigator::Node & in_Start, const Navigator::Node & in_Goal) const
+	double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
 	{
-		return 0.0;
+		const float l_DX = in_Start.x - in_Goal.x, l_DY = in_Start.y - in_Goal.y;
+		return std::sqrt(l_DX * l_DX + l_DY * l_DY);
+	}
+};
+
+class ManhattanDistance
+{
+public:
+	double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
+	{
+		return std::abs(in_Start.x - in_Goal.x) + std::abs(in_Start.y - in_Goal.y);
 	}
 };
 
-class EuclideanDistance : public IHeuristic
+// Exact cost on an empty grid where straight moves cost 1 and diagonal moves cost 1.42
+class OctileDistance
 {
 public:
-	double operator()(const Navigator::Node & in_Start, const Navigator::Node & in_Goal) const
+	double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
 	{
-		return sqrt(pow(in_Start.Position.x - in_Goal.Position.x, 2) + pow(in_Start.Position.y - in_Goal.Position.y, 2));
+		const float l_DX = std::abs(in_Start.x - in_Goal.x), l_DY = std::abs(in_Start.y - in_Goal.y);
+		return std::max(l_DX, l_DY) + 0.42 * std::min(l_DX, l_DY);
 	}
 };
 
-class ManhattanDistance : public IHeuristic
+// Needs the landmarks of the level the positions are on
+class LandmarkDistance
 {
+private:
+	const Landmarks & m_Landmarks;
+
 public:
-	double operator()(const Navigator::Node & in_Start, const Navigator::Node & in_Goal) const
+	explicit LandmarkDistance(const Landmarks & in_Landmarks) : m_Landmarks(in_Landmarks) { }
+
+	double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
+	{
+		return m_Landmarks.LowerBound(in_Start, in_Goal);
+	}
+};
+
+// The larger of two lower bounds is still a lower bound, and it is consistent when both are
+template<class FirstHeuristic, class SecondHeuristic>
+class MaxHeuristic
+{
+private:
+	FirstHeuristic m_First;
+	SecondHeuristic m_Second;
+
+public:
+	MaxHeuristic(const FirstHeuristic & in_First, const SecondHeuristic & in_Second) : m_First(in_First), m_Second(in_Second) { }
+
+	double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
+	{
+		return std::max(m_First(in_Start, in_Goal), m_Second(in_Start, in_Goal));
+	}
+};
+
+template<class FirstHeuristic, class SecondHeuristic>
+MaxHeuristic<FirstHeuristic, SecondHeuristic> MakeMaxHeuristic(const FirstHeuristic & in_First, const SecondHeuristic & in_Second)
+{
+	return MaxHeuristic<FirstHeuristic, SecondHeuristic>(in_First, in_Second);
+}
+
+// Half the difference between the estimates to a goal and to a start, the potential of the bidirectional searches (Ikeda et al.).
+// The search from the other end uses the opposite potential by swapping them. It is consistent when the heuristic is.
+template<class HeuristicType>
+class AveragePotential
+{
+private:
+	HeuristicType m_Heuristic;
+	Vector2 m_Start;
+	Vector2 m_Goal;
+
+public:
+	AveragePotential(const HeuristicType & in_Heuristic, const Vector2 & in_Start, const Vector2 & in_Goal) : 
+		m_Heuristic(in_Heuristic), m_Start(in_Start), m_Goal(in_Goal) { }
+
+	// The position searched for is the goal given to the constructor
+	double operator()(const Vector2 & in_Position, const Vector2 &) const
 	{
-		return abs(in_Start.Position.x - in_Goal.Position.x) + abs(in_Start.Position.y - in_Goal.Position.y);
+		return (m_Heuristic(in_Position, m_Goal) - m_Heuristic(in_Position, m_Start)) / 2.0;
 	}
 };
 
-#endif // IHEURISTIC_H
+#endif // HEURISTICS_H
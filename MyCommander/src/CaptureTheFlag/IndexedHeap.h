@@ -0,0 +1,167 @@
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* IndexedHeap
+* Binary min-heap over dense integer indices. Each index knows its slot in the heap so
+* its priority can be decreased in O(log n) without searching for it.
+* Ties are broken by insertion order to keep the searches deterministic.
+*/
+template<class Priority = double>
+class IndexedHeap
+{
+	struct Entry
+	{
+		Priority Key;
+		unsigned Sequence;
+		unsigned Index;
+	};
+
+private:
+	enum { M_ABSENT = -1 };
+
+	std::vector<Entry> m_Entries;
+	std::vector<int> m_Positions;
+	unsigned m_Sequence;
+
+public:
+	IndexedHeap(const unsigned in_Capacity = 0) : m_Positions(in_Capacity, M_ABSENT), m_Sequence(0) { }
+
+	// Makes room for indices in [0, in_Capacity[ and empties the heap
+	void Reset(const unsigned in_Capacity)
+	{
+		m_Entries.clear();
+		m_Entries.reserve(in_Capacity);
+		m_Positions.assign(in_Capacity, M_ABSENT);
+		m_Sequence = 0;
+	}
+
+	// Only touches the indices still queued
+	void Clear()
+	{
+		for(auto l_It = m_Entries.begin(); l_It != m_Entries.end(); ++l_It)
+			m_Positions[l_It->Index] = M_ABSENT;
+		m_Entries.clear();
+		m_Sequence = 0;
+	}
+
+	bool Empty() const { return m_Entries.empty(); }
+	unsigned Size() const { return static_cast<unsigned>(m_Entries.size()); }
+	unsigned Capacity() const { return static_cast<unsigned>(m_Positions.size()); }
+	bool Contains(const unsigned in_Index) const { return m_Positions[in_Index] != M_ABSENT; }
+
+	unsigned Top() const
+	{
+		assert(!Empty());
+		return m_Entries.front().Index;
+	}
+
+	Priority TopKey() const
+	{
+		assert(!Empty());
+		return m_Entries.front().Key;
+	}
+
+	// Inserts the index or lowers its priority if it is already queued
+	void Push(const unsigned in_Index, const Priority in_Key)
+	{
+		if(Contains(in_Index))
+		{
+			DecreaseKey(in_Index, in_Key);
+			return;
+		}
+
+		Entry l_Entry = { in_Key, m_Sequence++, in_Index };
+		m_Entries.push_back(l_Entry);
+		m_Positions[in_Index] = static_cast<int>(m_Entries.size() - 1);
+		SiftUp(m_Entries.size() - 1);
+	}
+
+	void DecreaseKey(const unsigned in_Index, const Priority in_Key)
+	{
+		assert(Contains(in_Index));
+		size_t l_Pos = m_Positions[in_Index];
+		if(!(in_Key < m_Entries[l_Pos].Key))
+			return;
+
+		m_Entries[l_Pos].Key = in_Key;
+		m_Entries[l_Pos].Sequence = m_Sequence++;
+		SiftUp(l_Pos);
+	}
+
+	unsigned Pop()
+	{
+		assert(!Empty());
+		unsigned l_Index = m_Entries.front().Index;
+		m_Positions[l_Index] = M_ABSENT;
+
+		if(m_Entries.size() > 1)
+		{
+			m_Entries.front() = m_Entries.back();
+			m_Positions[m_Entries.front().Index] = 0;
+			m_Entries.pop_back();
+			SiftDown(0);
+		}
+		else
+		{
+			m_Entries.pop_back();
+		}
+		return l_Index;
+	}
+
+private:
+	bool Before(const Entry & in_Entry1, const Entry & in_Entry2) const
+	{
+		return in_Entry1.Key < in_Entry2.Key
+			|| (!(in_Entry2.Key < in_Entry1.Key) && in_Entry1.Sequence < in_Entry2.Sequence);
+	}
+
+	void Swap(const size_t in_Pos1, const size_t in_Pos2)
+	{
+		std::swap(m_Entries[in_Pos1], m_Entries[in_Pos2]);
+		m_Positions[m_Entries[in_Pos1].Index] = static_cast<int>(in_Pos1);
+		m_Positions[m_Entries[in_Pos2].Index] = static_cast<int>(in_Pos2);
+	}
+
+	void SiftUp(size_t in_Pos)
+	{
+		while(in_Pos > 0)
+		{
+			size_t l_Parent = (in_Pos - 1) / 2;
+			if(!Before(m_Entries[in_Pos], m_Entries[l_Parent]))
+				break;
+			Swap(in_Pos, l_Parent);
+			in_Pos = l_Parent;
+		}
+	}
+
+	void SiftDown(size_t in_Pos)
+	{
+		const size_t l_Size = m_Entries.size();
+		for(;;)
+		{
+			size_t l_Smallest = in_Pos;
+			size_t l_Left = 2 * in_Pos + 1;
+			size_t l_Right = l_Left + 1;
+
+			if(l_Left < l_Size && Before(m_Entries[l_Left], m_Entries[l_Smallest]))
+				l_Smallest = l_Left;
+			if(l_Right < l_Size && Before(m_Entries[l_Right], m_Entries[l_Smallest]))
+				l_Smallest = l_Right;
+			if(l_Smallest == in_Pos)
+				break;
+
+			Swap(in_Pos, l_Smallest);
+			in_Pos = l_Smallest;
+		}
+	}
+};
+
+#endif // INDEXED_HEAP_H
@@ -0,0 +1,96 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "api\Vector2.h"
+#include "MappedArray.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* Landmarks
+* Distances on the grid from a few landmark cells to every cell of the map. By the triangle inequality,
+* |d(L, a) - d(L, b)| is a lower bound of d(a, b) for every landmark L (the ALT heuristic).
+* The distances of a cell to all the landmarks are stored together so that a bound reads two short rows.
+*/
+class Landmarks
+{
+private:
+	int m_Width;
+	std::vector<unsigned> m_Cells;
+	MappedArray<float> m_Distances;
+
+public:
+	Landmarks() : m_Width(0) { }
+
+	// Every distance is unknown until it is set
+	void Reset(const int in_Width, const unsigned in_NbCells, const unsigned in_NbLandmarks)
+	{
+		m_Width = in_Width;
+		m_Cells.assign(in_NbLandmarks, 0);
+		m_Distances.Owned().assign(static_cast<std::size_t>(in_NbCells) * in_NbLandmarks, std::numeric_limits<float>::infinity());
+	}
+
+	// Replaces the landmarks by ones saved before, the arguments are left empty
+	void Assign(const int in_Width, std::vector<unsigned> & io_Cells, MappedArray<float> & io_Distances)
+	{
+		m_Width = in_Width;
+		m_Cells.swap(io_Cells);
+		m_Distances = std::move(io_Distances);
+		io_Cells.clear();
+		io_Distances.clear();
+	}
+
+	void Clear()
+	{
+		m_Cells.clear();
+		m_Distances.clear();
+	}
+
+	bool Empty() const { return m_Cells.empty(); }
+	unsigned NbLandmarks() const { return static_cast<unsigned>(m_Cells.size()); }
+	const std::vector<unsigned> & Cells() const { return m_Cells; }
+	const MappedArray<float> & Distances() const { return m_Distances; }
+
+	void SetCell(const unsigned in_Landmark, const unsigned in_Cell) { m_Cells[in_Landmark] = in_Cell; }
+
+	void SetDistance(const unsigned in_Landmark, const unsigned in_Cell, const double in_Distance)
+	{
+		m_Distances.Owned()[static_cast<std::size_t>(in_Cell) * m_Cells.size() + in_Landmark] = static_cast<float>(in_Distance);
+	}
+
+	float Distance(const unsigned in_Landmark, const unsigned in_Cell) const
+	{
+		return m_Distances[static_cast<std::size_t>(in_Cell) * m_Cells.size() + in_Landmark];
+	}
+
+	// Infinity when a landmark reaches one of the cells but not the other, they are then in different parts of the map
+	double LowerBound(const Vector2 & in_Start, const Vector2 & in_Goal) const
+	{
+		const std::size_t l_NbLandmarks = m_Cells.size();
+		if(!l_NbLandmarks)
+			return 0.0;
+
+		const float * l_Start = m_Distances.data() + (static_cast<std::size_t>(in_Start.x) + static_cast<std::size_t>(in_Start.y) * m_Width) * l_NbLandmarks;
+		const float * l_Goal = m_Distances.data() + (static_cast<std::size_t>(in_Goal.x) + static_cast<std::size_t>(in_Goal.y) * m_Width) * l_NbLandmarks;
+
+		float l_Bound = 0.f;
+		for(std::size_t i = 0; i < l_NbLandmarks; ++i)
+		{
+			if(l_Start[i] == l_Goal[i])
+				continue;
+			if(l_Start[i] == std::numeric_limits<float>::infinity() || l_Goal[i] == std::numeric_limits<float>::infinity())
+				return std::numeric_limits<double>::infinity();
+			l_Bound = std::max(l_Bound, std::abs(l_Start[i] - l_Goal[i]));
+		}
+		return l_Bound;
+	}
+};
+
+#endif // LANDMARKS_H
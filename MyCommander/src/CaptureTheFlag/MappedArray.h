@@ -0,0 +1,78 @@
+#ifndef MAPPED_ARRAY_H
+#define MAPPED_ARRAY_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* MappedArray
+* Read-only array whose elements are either its own or a view on a memory mapping, which it keeps mapped.
+* The tables loaded from the navigation cache are views, so the processes loading the same level share
+* the pages of the file. The preprocessing writes its own elements through Owned, which drops the view.
+*/
+template<class T>
+class MappedArray
+{
+private:
+	std::vector<T> m_Owned;
+	boost::shared_ptr<const void> m_Mapping;
+	const T * m_View;
+	std::size_t m_ViewSize;
+
+public:
+	MappedArray() : m_View(nullptr), m_ViewSize(0) { }
+
+	MappedArray(const MappedArray & in_Array) : m_Owned(in_Array.m_Owned), m_Mapping(in_Array.m_Mapping),
+		m_View(in_Array.m_View), m_ViewSize(in_Array.m_ViewSize) { }
+
+	MappedArray(MappedArray && in_Array) : m_Owned(std::move(in_Array.m_Owned)), m_Mapping(std::move(in_Array.m_Mapping)),
+		m_View(in_Array.m_View), m_ViewSize(in_Array.m_ViewSize) { }
+
+	MappedArray & operator=(MappedArray in_Array)
+	{
+		m_Owned.swap(in_Array.m_Owned);
+		m_Mapping.swap(in_Array.m_Mapping);
+		m_View = in_Array.m_View;
+		m_ViewSize = in_Array.m_ViewSize;
+		return *this;
+	}
+
+	// The elements are in_Size elements at in_View, which stay valid as long as in_Mapping is held
+	void View(const boost::shared_ptr<const void> & in_Mapping, const T * in_View, const std::size_t in_Size)
+	{
+		std::vector<T>().swap(m_Owned);
+		m_Mapping = in_Mapping;
+		m_View = in_View;
+		m_ViewSize = in_Size;
+	}
+
+	// Elements of the array itself, empty when it was a view. The workers may share it once it is owned.
+	std::vector<T> & Owned()
+	{
+		if(m_Mapping)
+			m_Mapping.reset();
+		return m_Owned;
+	}
+
+	void clear()
+	{
+		m_Mapping.reset();
+		m_Owned.clear();
+	}
+
+	bool IsView() const { return m_Mapping.get() != nullptr; }
+	std::size_t size() const { return m_Mapping ? m_ViewSize : m_Owned.size(); }
+	bool empty() const { return !size(); }
+	const T * data() const { return m_Mapping ? m_View : (m_Owned.empty() ? nullptr : &m_Owned[0]); }
+	const T * begin() const { return data(); }
+	const T * end() const { return data() + size(); }
+	const T & operator[](const std::size_t in_Index) const { return data()[in_Index]; }
+};
+
+#endif // MAPPED_ARRAY_H
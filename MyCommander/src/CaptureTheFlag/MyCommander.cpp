@@ -12,6 +12,7 @@
 #include "api/CommanderFactory.h"
 #include "api/Commands.h"
 #include "api/GameInfo.h"
+#include "api/json.h"
 
 #include "Heuristics.h"
 
@@ -19,6 +20,8 @@ REGISTER_COMMANDER(MyCommander);
 
 const double MyCommander::M_TICKTIME = 80.0;
 const std::string MyCommander::M_QVALUESFILE = "QValues.json";
+// Filled by running the client with --bake, the levels that are not in it are preprocessed as usual
+const std::string MyCommander::M_NAVIGATIONCACHEDIR = "NavigationCache";
 const std::string MyCommander::M_GETFLAGSTR = "GetEnemyFlag";
 const std::string MyCommander::M_DEFENDSTR = "Defend";
 const std::string MyCommander::M_RETURNSTR = "ReturnToBase";
@@ -26,22 +29,37 @@ const std::string MyCommander::M_WAITSTR = "WaitEnemyBase";
 const std::string MyCommander::M_KILLSTR = "KillFlagCarrier";
 const std::string MyCommander::M_SUPPORTSTR = "SupportFlagCarrier";
 
+// After the cache directory, which is copied when it registers
+REGISTER_BAKER(MyCommander, &MyCommander::BakeNavigationCache, MyCommander::GetNavigationCacheDirectory());
+
 std::string MyCommander::getName() const
 {
     return "MyCommander";
 }
 
+// The settings shared by the matches and the bake, so that a baked level is preprocessed the way a match would do it
+void MyCommander::ConfigureNavigator(Navigator & io_Navigator, const std::string & in_CacheDirectory)
+{
+	io_Navigator.SetClusterSearch(Navigator::JumpPointSearch);
+	io_Navigator.SetCacheDirectory(in_CacheDirectory);
+}
+
 void MyCommander::initialize()
 {
 	std::for_each(m_game->team->members.begin(), m_game->team->members.end(), 
 			[this](BotInfo* in_BotInfo)
 		{
-			m_BotsAbstractPaths[in_BotInfo->name] = std::vector<std::shared_ptr<Navigator::Node>>(0);
+			m_BotsAbstractPaths[in_BotInfo->name] = Navigator::NodeVector(0);
 			m_BotsNodeIndex[in_BotInfo->name] = 0;
 			m_BotLastAction[in_BotInfo->name] = Planner::None;
 		});
 
-	m_Navigator.Init(m_level->blockHeights, m_level->height, m_level->width);
+	ConfigureNavigator(m_Navigator, M_NAVIGATIONCACHEDIR);
+	m_Navigator.ClearFlowGoals();
+	m_EnemyFlagSpawnGoal = m_Navigator.AddFlowGoal(m_game->enemyTeam->flagSpawnLocation);
+	m_FlagSpawnGoal = m_Navigator.AddFlowGoal(m_game->team->flagSpawnLocation);
+	m_FlagScoreGoal = m_Navigator.AddFlowGoal(m_game->team->flagScoreLocation);
+	m_Navigator.InitInBackground(m_level->blockHeights, m_level->height, m_level->width);
 #ifdef _LOAD_PLAN
 	m_Planner.Init(m_game, true);
 #else
@@ -59,7 +77,7 @@ void MyCommander::tick()
 		
 		if((m_BotLastAction[l_Bot->name] == Planner::GetEnemyFlag 
 			&& m_BotsAbstractPaths[l_Bot->name].size()
-			&& m_BotsAbstractPaths[l_Bot->name][m_BotsAbstractPaths[l_Bot->name].size()-1]->Position != m_game->enemyTeam->flag->position)
+			&& m_Navigator.GetPosition(m_BotsAbstractPaths[l_Bot->name][m_BotsAbstractPaths[l_Bot->name].size()-1]) != m_game->enemyTeam->flag->position)
 			|| (m_BotLastAction[l_Bot->name] == Planner::KillFlagCarrier && !m_game->team->flag->carrier))
 		{
 			m_BotsAbstractPaths[l_Bot->name].clear();
@@ -79,9 +97,6 @@ void MyCommander::tick()
 			ActionToCommand(l_Action, l_Bot);
 		}
 	}
-
-	m_Navigator.ProcessClusters(M_TICKTIME 
-		- boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now()-m_Start).count());
 }
 
 void MyCommander::shutdown() 
@@ -155,9 +170,16 @@ void MyCommander::ActionToCommand(const Planner::Actions in_Action, BotInfo* in_
 
 void MyCommander::CommandGetEnemyFlag(BotInfo* in_Bot)
 {
-	std::vector<Vector2> l_Path(ComputePathBeginning(in_Bot,
 	// NOTE : The bot position is supposed to always be set as per the SDK documentation, but in reality it isn't so I have to check
-	in_Bot->position ? *in_Bot->position : m_game->team->botSpawnArea.first, m_game->enemyTeam->flag->position));
+	const Vector2 l_Start(in_Bot->position ? *in_Bot->position : m_game->team->botSpawnArea.first);
+	if(m_game->enemyTeam->flag->position == m_game->enemyTeam->flagSpawnLocation && ComputeFlowPath(m_EnemyFlagSpawnGoal, l_Start))
+	{
+		issue(new ChargeCommand(in_Bot->name, m_Waypoints, M_GETFLAGSTR));
+		m_BotLastAction[in_Bot->name] = Planner::GetEnemyFlag;
+		return;
+	}
+
+	std::vector<Vector2> l_Path(ComputePathBeginning(in_Bot, l_Start, m_game->enemyTeam->flag->position));
 
 	if(l_Path.size())
 	{
@@ -196,11 +218,11 @@ void MyCommander::CommandKillFlagCarrier(BotInfo* in_Bot)
 {
 	if(m_game->team->flag->carrier)
 	{
-		std::vector<std::shared_ptr<Navigator::Node>> l_EnemyAbstractPath(m_Navigator.ComputeAbstractPath(
+		Navigator::NodeVector l_EnemyAbstractPath(m_Navigator.ComputeAbstractPath(
 			*m_game->team->flag->carrier->position,
 			m_game->enemyTeam->flagScoreLocation));
 
-		std::vector<std::shared_ptr<Navigator::Node>> l_BotAbstractPath(m_Navigator.ComputeAbstractPath(
+		Navigator::NodeVector l_BotAbstractPath(m_Navigator.ComputeAbstractPath(
 			*in_Bot->position,
 			m_game->enemyTeam->flagScoreLocation));
 
@@ -209,14 +231,14 @@ void MyCommander::CommandKillFlagCarrier(BotInfo* in_Bot)
 
 		m_BotsAbstractPaths[in_Bot->name] = l_BotAbstractPath;
 
-		std::vector<Vector2> l_ConcretePath(m_Navigator.ComputeConcretePath(
+		m_Navigator.ComputeConcretePath(
 				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]], 
-				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
+				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
 
-		if(l_ConcretePath.empty())
-			issue(new ChargeCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position, M_KILLSTR));
+		if(m_Waypoints.empty())
+			issue(new ChargeCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]), M_KILLSTR));
 		else
-			issue(new ChargeCommand(in_Bot->name, l_ConcretePath, M_KILLSTR));
+			issue(new ChargeCommand(in_Bot->name, m_Waypoints, M_KILLSTR));
 		m_BotsNodeIndex[in_Bot->name]+=2;
 
 	}
@@ -227,6 +249,13 @@ void MyCommander::CommandDefend(BotInfo* in_Bot)
 {
 	if(in_Bot->position->squaredDistance(m_game->team->flag->position) > 1.f)
 	{
+		if(m_game->team->flag->position == m_game->team->flagSpawnLocation && ComputeFlowPath(m_FlagSpawnGoal, *in_Bot->position))
+		{
+			issue(new ChargeCommand(in_Bot->name, m_Waypoints, M_DEFENDSTR));
+			m_BotLastAction[in_Bot->name] = Planner::Defend;
+			return;
+		}
+
 		std::vector<Vector2> l_Path(ComputePathBeginning(in_Bot, 
 			*in_Bot->position, m_game->team->flag->position));
 		if(l_Path.size())
@@ -251,15 +280,15 @@ void MyCommander::CommandSupportFlagCarrier(BotInfo* in_Bot)
 {
 	if(m_game->enemyTeam->flag->carrier)
 	{
-		std::vector<std::shared_ptr<Navigator::Node>> l_BotAbstractPath(m_Navigator.ComputeAbstractPath(
+		Navigator::NodeVector l_BotAbstractPath(m_Navigator.ComputeAbstractPath(
 			*in_Bot->position,
 			m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name].size() ?
-			m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name][m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name].size()/2]->Position :
+			m_Navigator.GetPosition(m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name][m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name].size()/2]) :
 			m_game->enemyTeam->flag->position));
 
-		std::vector<std::shared_ptr<Navigator::Node>> l_ReturnPath(m_Navigator.ComputeAbstractPath(
+		Navigator::NodeVector l_ReturnPath(m_Navigator.ComputeAbstractPath(
 			m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name].size() ?
-			m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name][m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name].size()/2]->Position :
+			m_Navigator.GetPosition(m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name][m_BotsAbstractPaths[m_game->enemyTeam->flag->carrier->name].size()/2]) :
 			m_game->enemyTeam->flag->position,
 			m_game->team->flagScoreLocation));
 
@@ -268,15 +297,15 @@ void MyCommander::CommandSupportFlagCarrier(BotInfo* in_Bot)
 
 		if(l_BotAbstractPath.size())
 		{
-			std::vector<Vector2> l_ConcretePath(m_Navigator.ComputeConcretePath(
+			m_Navigator.ComputeConcretePath(
 					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]], 
-					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
+					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
 
-			if(l_ConcretePath.empty())
-				issue(new AttackCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position, 
+			if(m_Waypoints.empty())
+				issue(new AttackCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]), 
 				GetBestLookAt(in_Bot), M_SUPPORTSTR));
 			else
-				issue(new AttackCommand(in_Bot->name, l_ConcretePath, 
+				issue(new AttackCommand(in_Bot->name, m_Waypoints, 
 				GetBestLookAt(in_Bot), M_SUPPORTSTR));
 			m_BotsNodeIndex[in_Bot->name]+=2;
 		}
@@ -286,6 +315,13 @@ void MyCommander::CommandSupportFlagCarrier(BotInfo* in_Bot)
 
 void MyCommander::CommandReturnToBase(BotInfo* in_Bot)
 {
+	if(ComputeFlowPath(m_FlagScoreGoal, *in_Bot->position))
+	{
+		issue(new ChargeCommand(in_Bot->name, m_Waypoints, M_RETURNSTR));
+		m_BotLastAction[in_Bot->name] = Planner::ReturnToBase;
+		return;
+	}
+
 	std::vector<Vector2> l_Path(ComputePathBeginning(in_Bot, 
 		*in_Bot->position, m_game->team->flagScoreLocation));
 	if(l_Path.size())
@@ -302,18 +338,26 @@ std::vector<Vector2> MyCommander::ComputePathBeginning(BotInfo * in_Bot, const V
 
 	if(m_BotsAbstractPaths[in_Bot->name].size())
 	{
-		Vector2 l_Goal = m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position;
-		std::vector<Vector2> l_ConcretePath(m_Navigator.ComputeConcretePath(
+		Vector2 l_Goal = m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]);
+		m_Navigator.ComputeConcretePath(
 				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]], 
-				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
+				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
 
-		if(l_ConcretePath.empty())
-			l_ConcretePath.push_back(in_Goal);
-		return l_ConcretePath;
+		if(m_Waypoints.empty())
+			m_Waypoints.push_back(in_Goal);
+		return m_Waypoints;
 	}
 	return std::vector<Vector2>();
 }
 
+// The whole path to a fixed goal is read from its flow field and left in m_Waypoints. The bot has no abstract path
+// to complete so it is given a new order once it gets there.
+bool MyCommander::ComputeFlowPath(const unsigned in_Goal, const Vector2 & in_Start)
+{
+	m_Waypoints.clear();
+	return m_Navigator.GetFlowPath(in_Goal, in_Start, m_Waypoints);
+}
+
 void MyCommander::CompletePath(BotInfo* in_Bot)
 {
 	std::string l_Intention;
@@ -348,17 +392,17 @@ void MyCommander::CompletePath(BotInfo* in_Bot)
 		{
 			if(m_BotsNodeIndex[in_Bot->name] == m_BotsAbstractPaths[in_Bot->name].size()-1)
 			{
-				issue(new ChargeCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]]->Position, l_Intention));
+				issue(new ChargeCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]]), l_Intention));
 			}
 			else
 			{
-				Vector2 l_Goal = m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position;
-				std::vector<Vector2> l_ConcretePath( m_Navigator.ComputeConcretePath(
+				Vector2 l_Goal = m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]);
+				m_Navigator.ComputeConcretePath(
 							m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]], 
-							m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
+							m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
 
-				if(l_ConcretePath.size())
-					issue(new ChargeCommand(in_Bot->name, l_ConcretePath, l_Intention));
+				if(m_Waypoints.size())
+					issue(new ChargeCommand(in_Bot->name, m_Waypoints, l_Intention));
 				else
 					issue(new ChargeCommand(in_Bot->name, l_Goal, l_Intention));
 			}
@@ -370,17 +414,17 @@ void MyCommander::CompletePath(BotInfo* in_Bot)
 		{
 			if(m_BotsNodeIndex[in_Bot->name] == m_BotsAbstractPaths[in_Bot->name].size()-1)
 			{
-				issue(new ChargeCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]]->Position, l_Intention));
+				issue(new ChargeCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]]), l_Intention));
 			}
 			else
 			{
-				Vector2 l_Goal = m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position;
-				std::vector<Vector2> l_ConcretePath( m_Navigator.ComputeConcretePath(
+				Vector2 l_Goal = m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]);
+				m_Navigator.ComputeConcretePath(
 							m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]], 
-							m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
+							m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
 
-				if(l_ConcretePath.size())
-					issue(new ChargeCommand(in_Bot->name, l_ConcretePath, l_Intention));
+				if(m_Waypoints.size())
+					issue(new ChargeCommand(in_Bot->name, m_Waypoints, l_Intention));
 				else
 					issue(new ChargeCommand(in_Bot->name, l_Goal, l_Intention));
 			}
@@ -392,25 +436,25 @@ void MyCommander::CompletePath(BotInfo* in_Bot)
 			if((abs(in_Bot->position->x - m_game->enemyTeam->flagScoreLocation.x) 
 				+ abs(in_Bot->position->y - m_game->enemyTeam->flagScoreLocation.y)) < 1.f)
 			{
-				std::vector<Vector2> l_ConcretePath(m_Navigator.ComputeConcretePath(
+				m_Navigator.ComputeConcretePath(
 					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]],
-					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
-				if(l_ConcretePath.size())
-					issue(new AttackCommand(in_Bot->name, l_ConcretePath, 
+					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
+				if(m_Waypoints.size())
+					issue(new AttackCommand(in_Bot->name, m_Waypoints, 
 					GetBestLookAt(in_Bot), l_Intention));
 				else
-					issue(new AttackCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position, 
+					issue(new AttackCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]), 
 					GetBestLookAt(in_Bot), l_Intention));
 			}
 			else
 			{
-				std::vector<Vector2> l_ConcretePath(m_Navigator.ComputeConcretePath(
+				m_Navigator.ComputeConcretePath(
 					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]],
-					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
-				if(l_ConcretePath.size())
-					issue(new ChargeCommand(in_Bot->name, l_ConcretePath, l_Intention));
+					m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
+				if(m_Waypoints.size())
+					issue(new ChargeCommand(in_Bot->name, m_Waypoints, l_Intention));
 				else
-					issue(new ChargeCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position, l_Intention));
+					issue(new ChargeCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]), l_Intention));
 			}
 			m_BotsNodeIndex[in_Bot->name]+=2;
 			break;
@@ -418,14 +462,14 @@ void MyCommander::CompletePath(BotInfo* in_Bot)
 		case Planner::SupportFlagCarrier:
 		case Planner::WaitEnemyBase:		
 		{
-			std::vector<Vector2> l_ConcretePath(m_Navigator.ComputeConcretePath(
+			m_Navigator.ComputeConcretePath(
 				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]],
-				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]));
-			if(l_ConcretePath.size())
-				issue(new AttackCommand(in_Bot->name, l_ConcretePath, 
+				m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1], m_Waypoints);
+			if(m_Waypoints.size())
+				issue(new AttackCommand(in_Bot->name, m_Waypoints, 
 				GetBestLookAt(in_Bot), l_Intention));
 			else
-				issue(new AttackCommand(in_Bot->name, m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]->Position,
+				issue(new AttackCommand(in_Bot->name, m_Navigator.GetPosition(m_BotsAbstractPaths[in_Bot->name][m_BotsNodeIndex[in_Bot->name]+1]),
 				GetBestLookAt(in_Bot), l_Intention));
 			m_BotsNodeIndex[in_Bot->name]+=2;
 			break;
@@ -433,22 +477,34 @@ void MyCommander::CompletePath(BotInfo* in_Bot)
 	}
 }
 
-boost::optional<Vector2> MyCommander::GetBestLookAt(const BotInfo* in_Bot) const
+// The closest enemy is the one the bot would have to walk the least to reach, not the one that is the closest as the crow flies.
+// The walking distances are only read from the distance table, a search per enemy does not fit in a tick. Without the table, or
+// when no enemy can be reached from the cell of the bot, e.g. one against a wall, the closest enemy by octile distance is picked.
+boost::optional<Vector2> MyCommander::GetBestLookAt(const BotInfo* in_Bot)
 {
-	boost::optional<Vector2> l_BestLookAt;
+	const bool l_UseTable = m_Navigator.IsHierarchyReady() && m_Navigator.HasDistanceTable();
+	boost::optional<Vector2> l_BestLookAt, l_NearestLookAt;
 	double l_ClosestDistance = std::numeric_limits<double>::infinity();
+	double l_NearestDistance = std::numeric_limits<double>::infinity();
 	std::for_each(m_game->enemyTeam->members.begin(), m_game->enemyTeam->members.end(), 
-		[&l_BestLookAt, &l_ClosestDistance, &in_Bot](const BotInfo* in_EnemyBot)
+		[&l_BestLookAt, &l_NearestLookAt, &l_ClosestDistance, &l_NearestDistance, &in_Bot, l_UseTable, this](const BotInfo* in_EnemyBot)
 	{
-		double l_Distance = abs(in_Bot->position->x - in_EnemyBot->position->x) 
-			+ abs(in_Bot->position->y - in_EnemyBot->position->y);
+		const double l_Distance = l_UseTable ? m_Navigator.GetDistance(*in_Bot->position, *in_EnemyBot->position) 
+			: std::numeric_limits<double>::infinity();
 		if(l_Distance < l_ClosestDistance)
 		{
 			l_BestLookAt = in_EnemyBot->position;
 			l_ClosestDistance = l_Distance;
 		}
+
+		const double l_Nearest = OctileDistance()(*in_Bot->position, *in_EnemyBot->position);
+		if(l_Nearest < l_NearestDistance)
+		{
+			l_NearestLookAt = in_EnemyBot->position;
+			l_NearestDistance = l_Nearest;
+		}
 	});
-	return l_BestLookAt;
+	return l_BestLookAt ? l_BestLookAt : l_NearestLookAt;
 }
 
 void MyCommander::Reset()
@@ -456,3 +512,29 @@ void MyCommander::Reset()
 	m_Navigator.Reset();
 	m_Planner.Reset();
 }
+
+bool MyCommander::BakeNavigationCache(const std::string & in_LevelFile, const std::string & in_CacheDirectory)
+{
+	std::ifstream l_FileStream(in_LevelFile, std::ios::in | std::ios::binary);
+	std::string l_Content;
+	if(l_FileStream.is_open())
+	{
+		l_FileStream.seekg(0, std::ios::end);
+		unsigned l_Size = static_cast<unsigned>(l_FileStream.tellg());
+		l_Content.resize(l_Size);
+		l_FileStream.seekg(0, std::ios::beg);
+		l_FileStream.read(&l_Content[0], l_Content.size());
+		l_FileStream.close();
+	}
+
+	json_spirit::mValue l_Value;
+	if(!json_spirit::read_string(l_Content, l_Value) || l_Value.type() != json_spirit::obj_type 
+		|| l_Value.get_obj().count("__class__") == 0 || !(l_Value.get_obj().find("__class__")->second == "LevelInfo"))
+		return false;
+
+	std::unique_ptr<LevelInfo> l_Level(fromJSON<LevelInfo>(l_Value));
+	Navigator l_Navigator;
+	ConfigureNavigator(l_Navigator, in_CacheDirectory);
+	l_Navigator.Init(l_Level->blockHeights, l_Level->height, l_Level->width);
+	return l_Navigator.IsLoadedFromCache() || l_Navigator.IsSavedToCache();
+}
@@ -22,6 +22,7 @@ class MyCommander : public Commander
 private:
 	static const double M_TICKTIME;
 	static const std::string M_QVALUESFILE;
+	static const std::string M_NAVIGATIONCACHEDIR;
 	static const std::string M_GETFLAGSTR;
 	static const std::string M_DEFENDSTR;
 	static const std::string M_RETURNSTR;
@@ -33,17 +34,25 @@ private:
 	Navigator m_Navigator;
 	Planner m_Planner;
 	boost::chrono::high_resolution_clock::time_point m_Start;
-	std::map<std::string, std::vector<std::shared_ptr<Navigator::Node>>> m_BotsAbstractPaths;
+	std::map<std::string, Navigator::NodeVector> m_BotsAbstractPaths;
+	// Reused by every concrete path query
+	std::vector<Vector2> m_Waypoints;
 	std::map<std::string, unsigned> m_BotsNodeIndex;
 	std::map<std::string, Planner::Actions> m_BotLastAction;
+	// Flow fields of the Navigator toward the fixed goals of the match
+	unsigned m_EnemyFlagSpawnGoal;
+	unsigned m_FlagSpawnGoal;
+	unsigned m_FlagScoreGoal;
 
 private:
+	static void ConfigureNavigator(Navigator & io_Navigator, const std::string & in_CacheDirectory);
 	Planner::State GetBotState(const BotInfo* in_Bot);
 	void CompletePath(BotInfo* in_Bot);
 	void ActionToCommand(const Planner::Actions in_Action, BotInfo* in_Bot);
 	std::vector<Vector2> ComputePathBeginning(BotInfo * in_Bot, const Vector2 & in_Start, const Vector2 & in_Goal);
+	bool ComputeFlowPath(const unsigned in_Goal, const Vector2 & in_Start);
 	
-	boost::optional<Vector2> GetBestLookAt(const BotInfo* in_BotInfo) const;
+	boost::optional<Vector2> GetBestLookAt(const BotInfo* in_BotInfo);
 
 	void CommandGetEnemyFlag(BotInfo* in_Bot);
 	void CommandWaitEnemyBase(BotInfo* in_Bot);
@@ -53,13 +62,18 @@ private:
 	void CommandReturnToBase(BotInfo* in_Bot);
 
 public:
-	MyCommander() { }
+	MyCommander() : m_EnemyFlagSpawnGoal(0), m_FlagSpawnGoal(0), m_FlagScoreGoal(0) { }
 
 	virtual std::string getName() const;
     virtual void initialize();
     virtual void tick();
     virtual void shutdown();
 	void Reset();
+
+	// Preprocesses a level saved as JSON the way initialize does and saves it in the navigation cache of in_CacheDirectory.
+	// Returns false when the level cannot be read or its preprocessing is not in the cache afterwards.
+	static bool BakeNavigationCache(const std::string & in_LevelFile, const std::string & in_CacheDirectory);
+	static const std::string & GetNavigationCacheDirectory() { return M_NAVIGATIONCACHEDIR; }
 };
 
 #endif // MY_COMMANDER_H
@@ -0,0 +1,279 @@
+#ifndef NAVIGATION_CACHE_H
+#define NAVIGATION_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/has_trivial_assign.hpp>
+#include <boost/type_traits/has_trivial_copy.hpp>
+
+#include "api\Vector2.h"
+#include "MappedArray.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* NavigationCache
+* Binary format of the preprocessed Navigator. The file is a sequence of scalars and arrays, an array being
+* its number of elements followed by the elements themselves aligned on 8 bytes so they can be used
+* straight out of a memory mapping. Vectors of vectors are written as a count followed by each vector.
+* The vectors are read as copies, the MappedArrays as views on the mapping the reader was given.
+* Only the trivially copyable types are copied as bytes, the positions and the pairs are written field by field.
+*/
+
+// The types whose bytes can be copied to and from the file
+template<class T>
+struct IsCacheable
+{
+	static const bool value = boost::has_trivial_copy<T>::value && boost::has_trivial_assign<T>::value;
+};
+
+// 64-bit FNV-1a, used to fingerprint the levels
+inline std::uint64_t HashBytes(const void * in_Data, const std::size_t in_Size, std::uint64_t in_Hash = 14695981039346656037ULL)
+{
+	const unsigned char * l_Bytes = static_cast<const unsigned char *>(in_Data);
+	for(std::size_t i = 0; i < in_Size; ++i)
+	{
+		in_Hash ^= l_Bytes[i];
+		in_Hash *= 1099511628211ULL;
+	}
+	return in_Hash;
+}
+
+class CacheWriter
+{
+private:
+	std::ofstream m_Stream;
+	std::size_t m_Offset;
+
+public:
+	explicit CacheWriter(const std::string & in_FileName) : m_Stream(in_FileName, std::ios::out | std::ios::binary), m_Offset(0) { }
+
+	bool Good() const { return m_Stream.good(); }
+
+	void Close() { m_Stream.close(); }
+
+	template<class T>
+	void Write(const T & in_Value)
+	{
+		static_assert(IsCacheable<T>::value, "Only trivially copyable values are written as bytes");
+		WriteBytes(&in_Value, sizeof(T));
+	}
+
+	void Write(const Vector2 & in_Position)
+	{
+		Write(in_Position.x);
+		Write(in_Position.y);
+	}
+
+	template<class T1, class T2>
+	void Write(const std::pair<T1, T2> & in_Pair)
+	{
+		Write(in_Pair.first);
+		Write(in_Pair.second);
+	}
+
+	void WriteCount(const std::size_t in_Count)
+	{
+		Write(static_cast<std::uint64_t>(in_Count));
+	}
+
+	template<class T>
+	void Write(const std::vector<T> & in_Values)
+	{
+		static_assert(IsCacheable<T>::value, "Only arrays of trivially copyable values are written as bytes");
+		WriteCount(in_Values.size());
+		Align();
+		if(!in_Values.empty())
+			WriteBytes(&in_Values[0], in_Values.size() * sizeof(T));
+	}
+
+	// Laid out like an array of the pairs, field by field
+	template<class T1, class T2>
+	void Write(const std::vector<std::pair<T1, T2>> & in_Values)
+	{
+		WriteCount(in_Values.size());
+		Align();
+		for(auto l_It = in_Values.begin(); l_It != in_Values.end(); ++l_It)
+			Write(*l_It);
+	}
+
+	template<class T>
+	void Write(const MappedArray<T> & in_Values)
+	{
+		static_assert(IsCacheable<T>::value, "Only arrays of trivially copyable values are written as bytes");
+		WriteCount(in_Values.size());
+		Align();
+		if(!in_Values.empty())
+			WriteBytes(in_Values.data(), in_Values.size() * sizeof(T));
+	}
+
+	template<class T>
+	void Write(const std::vector<std::vector<T>> & in_Values)
+	{
+		WriteCount(in_Values.size());
+		for(auto l_It = in_Values.begin(); l_It != in_Values.end(); ++l_It)
+			Write(*l_It);
+	}
+
+private:
+	void WriteBytes(const void * in_Data, const std::size_t in_Size)
+	{
+		m_Stream.write(static_cast<const char *>(in_Data), in_Size);
+		m_Offset += in_Size;
+	}
+
+	void Align()
+	{
+		static const char l_Padding[8] = { 0 };
+		WriteBytes(l_Padding, (8 - m_Offset % 8) % 8);
+	}
+};
+
+// Reads from memory that starts on an 8-byte boundary, e.g. a mapped file held by in_Mapping. Without a mapping
+// to hold, the MappedArrays are read as copies. Every read fails once one went past the end.
+class CacheReader
+{
+private:
+	const char * m_Begin;
+	const char * m_Cursor;
+	const char * m_End;
+	boost::shared_ptr<const void> m_Mapping;
+
+public:
+	CacheReader(const void * in_Data, const std::size_t in_Size, const boost::shared_ptr<const void> & in_Mapping = boost::shared_ptr<const void>()) :
+		m_Begin(static_cast<const char *>(in_Data)), m_Cursor(m_Begin), m_End(m_Begin + in_Size), m_Mapping(in_Mapping) { }
+
+	bool Good() const { return m_Cursor != nullptr; }
+
+	template<class T>
+	bool Read(T & out_Value)
+	{
+		static_assert(IsCacheable<T>::value, "Only trivially copyable values are read as bytes");
+		if(!Good() || static_cast<std::size_t>(m_End - m_Cursor) < sizeof(T))
+			return Fail();
+
+		std::memcpy(&out_Value, m_Cursor, sizeof(T));
+		m_Cursor += sizeof(T);
+		return true;
+	}
+
+	bool Read(Vector2 & out_Position)
+	{
+		return Read(out_Position.x) && Read(out_Position.y);
+	}
+
+	template<class T1, class T2>
+	bool Read(std::pair<T1, T2> & out_Pair)
+	{
+		return Read(out_Pair.first) && Read(out_Pair.second);
+	}
+
+	template<class T>
+	bool Read(std::vector<T> & out_Values)
+	{
+		std::size_t l_Size = 0;
+		const T * l_First = ReadArray<T>(l_Size);
+		if(!Good())
+			return false;
+
+		out_Values.assign(l_First, l_First + l_Size);
+		return true;
+	}
+
+	template<class T1, class T2>
+	bool Read(std::vector<std::pair<T1, T2>> & out_Values)
+	{
+		std::size_t l_Size = 0;
+		if(!ReadCount(l_Size, sizeof(T1) + sizeof(T2)))
+			return false;
+
+		m_Cursor += (8 - (m_Cursor - m_Begin) % 8) % 8;
+		if(m_Cursor > m_End)
+			return Fail();
+
+		out_Values.resize(l_Size);
+		for(auto l_It = out_Values.begin(); l_It != out_Values.end(); ++l_It)
+			if(!Read(*l_It))
+				return false;
+		return true;
+	}
+
+	template<class T>
+	bool Read(MappedArray<T> & out_Values)
+	{
+		std::size_t l_Size = 0;
+		const T * l_First = ReadArray<T>(l_Size);
+		if(!Good())
+			return false;
+
+		if(m_Mapping)
+			out_Values.View(m_Mapping, l_First, l_Size);
+		else
+			out_Values.Owned().assign(l_First, l_First + l_Size);
+		return true;
+	}
+
+	// Reads a number of elements that take at least in_ElementSize bytes each in what is left of the data
+	bool ReadCount(std::size_t & out_Count, const std::size_t in_ElementSize)
+	{
+		std::uint64_t l_Count = 0;
+		if(!Read(l_Count) || l_Count > static_cast<std::uint64_t>(m_End - m_Cursor) / in_ElementSize)
+			return Fail();
+
+		out_Count = static_cast<std::size_t>(l_Count);
+		return true;
+	}
+
+	template<class T>
+	bool Read(std::vector<std::vector<T>> & out_Values)
+	{
+		std::size_t l_Size = 0;
+		if(!ReadCount(l_Size, sizeof(std::uint64_t)))
+			return false;
+
+		out_Values.resize(l_Size);
+		for(auto l_It = out_Values.begin(); l_It != out_Values.end(); ++l_It)
+			if(!Read(*l_It))
+				return false;
+		return true;
+	}
+
+private:
+	// The elements of the next array, which is skipped
+	template<class T>
+	const T * ReadArray(std::size_t & out_Size)
+	{
+		static_assert(IsCacheable<T>::value, "Only arrays of trivially copyable values are read as bytes");
+		std::uint64_t l_Size = 0;
+		if(!Read(l_Size))
+			return nullptr;
+
+		m_Cursor += (8 - (m_Cursor - m_Begin) % 8) % 8;
+		if(m_Cursor > m_End || l_Size > static_cast<std::uint64_t>(m_End - m_Cursor) / sizeof(T))
+		{
+			Fail();
+			return nullptr;
+		}
+
+		const T * l_First = reinterpret_cast<const T *>(m_Cursor);
+		out_Size = static_cast<std::size_t>(l_Size);
+		m_Cursor += out_Size * sizeof(T);
+		return l_First;
+	}
+
+	bool Fail()
+	{
+		m_Cursor = nullptr;
+		return false;
+	}
+};
+
+#endif // NAVIGATION_CACHE_H
@@ -7,24 +7,84 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
 #include <limits>
+#include <random>
 #include <set>
+#include <sstream>
 
-#include "Heuristics.h"
-#include "Resumable.h"
+#include <boost/interprocess/detail/os_thread_functions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
-const int Navigator::M_MAXCLUSTERSIZE = 20;
+#include "Heuristics.h"
+#include "IndexedHeap.h"
+#include "NavigationCache.h"
+#include "ParallelFor.h"
+
+const int Navigator::M_CLUSTERGROUPSIZE = 4;
+const unsigned Navigator::M_MAXTOPCLUSTERS = 256;
+const std::size_t Navigator::M_CONCRETECACHEBUDGET = 4 * 1024 * 1024;
+const std::size_t Navigator::M_ABSTRACTCACHEBUDGET = 1024 * 1024;
+const std::size_t Navigator::M_CLUSTERPATHSBUDGET = 16 * 1024 * 1024;
+const std::size_t Navigator::M_DISTANCETABLEBUDGET = 16 * 1024 * 1024;
+// Also bounds the time taken by their searches, which visit every cell of the map
+const std::size_t Navigator::M_LANDMARKSBUDGET = 4 * 1024 * 1024;
+// "NAVC" and the version of the cache format, to be bumped whenever what Preprocess builds changes
+const std::uint32_t Navigator::M_CACHEMAGIC = 0x4E415643;
+const std::uint32_t Navigator::M_CACHEVERSION = 3;
 
 void Navigator::Init(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
 					 const int in_MaxEntranceWidth)
+{
+	LoadLevel(in_Level, in_Length, in_Width, in_MaxEntranceWidth);
+	if(!LoadCache())
+	{
+		Preprocess();
+		m_SavedToCache = SaveCache();
+	}
+	BuildFlowFields();
+	m_HierarchyReady = true;
+}
+
+void Navigator::InitInBackground(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
+								 const int in_MaxEntranceWidth)
+{
+	LoadLevel(in_Level, in_Length, in_Width, in_MaxEntranceWidth);
+	if(LoadCache())
+	{
+		BuildFlowFields();
+		m_HierarchyReady = true;
+		m_Worker = boost::thread(&Navigator::ProcessClusters, this);
+	}
+	else
+	{
+		m_Worker = boost::thread(&Navigator::BuildInBackground, this);
+	}
+}
+
+// Creates the base nodes and the grid, every query can be answered on the flat grid from there
+void Navigator::LoadLevel(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
+						  const int in_MaxEntranceWidth)
 {
 	int l_X = 0, l_Y = 0;
+	m_LevelLength = in_Length;
+	m_LevelWidth = in_Width;
+	m_AbstractNodes.assign(in_Length * in_Width, NodeId(M_NONODE));
+	// Every cell can have a base node and an abstract node
+	m_Nodes.Reserve(2 * in_Length * in_Width);
+	m_SearchContext.Resize(2 * in_Length * in_Width);
+	m_FlatContext.Resize(in_Length * in_Width);
 	m_Clusters.push_back(std::vector<Cluster>(1, Cluster(0, in_Length, in_Width, NodeVector(), NodeVector(in_Length * in_Width))));
+	m_Tilings.push_back(Tiling(in_Length, in_Width, 1, 1));
 	auto l_Cluster = m_Clusters[0].begin();
 	std::for_each(in_Level.get(), in_Level.get() + in_Length * in_Width, [&l_Cluster, &in_Width, &l_X, &l_Y, this](const float in_Block)
 	{
 		// The first level cluster is in fact the whole map
-		l_Cluster->LevelNodes[l_X + l_Y * in_Width] = (std::make_shared<Node>(Navigator::Node(0, static_cast<int>(in_Block), Vector2(static_cast<float>(l_X), static_cast<float>(l_Y)))));
+		// Base nodes are created first so their index is also their cell index
+		l_Cluster->LevelNodes[l_X + l_Y * in_Width] = m_Nodes.Add(0, static_cast<int>(in_Block), Vector2(static_cast<float>(l_X), static_cast<float>(l_Y)));
 		
 		if(l_X < in_Width - 1)
 		{
@@ -37,180 +97,787 @@ void Navigator::Init(const std::unique_ptr<float[]> & in_Level, const int in_Len
 		}
 	});
 		
-	BuildLocalGraph(in_Length, in_Width, l_Cluster->LevelNodes, l_Cluster->LocalGraph);
-
-	m_Graphs.push_back(l_Cluster->LocalGraph);
+	m_Grid.Build(in_Level, in_Length, in_Width);
+	LabelComponents();
+	m_Graphs.push_back(CompactGraph());
 	m_MaxEntranceWidth = in_MaxEntranceWidth;
 
-	Preprocess();
+	// Everything Preprocess depends on is part of the fingerprint
+	m_CachePath.clear();
+	if(!m_CacheDirectory.empty())
+	{
+		const std::int32_t l_Parameters[] = { static_cast<std::int32_t>(M_CACHEVERSION), in_Length, in_Width, in_MaxEntranceWidth, m_MaxDepth, 
+			M_MAXCLUSTERSIZE, M_CLUSTERGROUPSIZE, static_cast<std::int32_t>(M_MAXTOPCLUSTERS), static_cast<std::int32_t>(m_NbLandmarks) };
+		m_Fingerprint = HashBytes(in_Level.get(), in_Length * in_Width * sizeof(float), HashBytes(l_Parameters, sizeof(l_Parameters)));
+
+		std::ostringstream l_Path;
+		l_Path << m_CacheDirectory << '/' << std::hex << std::setw(16) << std::setfill('0') << m_Fingerprint << ".nav";
+		m_CachePath = l_Path.str();
+	}
+}
+
+// Runs on the background worker. Nothing built here is read by the queries before the hierarchy is flagged as ready,
+// the mutex makes all of it visible to them. The hierarchy is built with the interruptions disabled, so Reset and
+// the destructor wait for it and the joins of the preprocessing workers are never cut short. Their request is
+// seen by ProcessClusters.
+void Navigator::BuildInBackground()
+{
+	{
+		boost::this_thread::disable_interruption l_NoInterruption;
+		Preprocess();
+		// The flow fields depend on the goals of the match, they are not part of the cache
+		m_SavedToCache = SaveCache();
+		BuildFlowFields();
+		boost::lock_guard<boost::mutex> l_Lock(m_HierarchyMutex);
+		m_HierarchyReady = true;
+	}
+	ProcessClusters();
+}
+
+bool Navigator::IsHierarchyReady() const
+{
+	boost::lock_guard<boost::mutex> l_Lock(m_HierarchyMutex);
+	return m_HierarchyReady;
 }
 
 void Navigator::Reset()
 {
+	StopClusterProcessing();
+	m_HierarchyReady = false;
+	m_LoadedFromCache = false;
+	m_SavedToCache = false;
+	m_CachePath.clear();
+	m_ClusterPaths.clear();
 	m_Clusters.clear();
+	m_Tilings.clear();
+	m_Grid.Clear();
+	m_Components.clear();
+	m_ClusterComponents.clear();
 	m_Graphs.clear();
+	m_DistanceTable.clear();
+	m_TableOffsets.clear();
+	m_Landmarks.Clear();
+	m_FlowFields.clear();
 	m_Entrances.clear();
-	m_Paths.clear();
+	m_ConcretePaths.Clear();
+	m_AbstractPaths.Clear();
+	m_Nodes.Clear();
+	m_AbstractNodes.clear();
+	m_Statistics = SearchStatistics();
+	m_FlatStatistics = SearchStatistics();
 }
 
-double Navigator::AStar(const std::shared_ptr<Node> & in_Start, const std::shared_ptr<Node> & in_Goal, 
-						Graph & in_Graph, IHeuristic && in_Heuristic)
+// Maps the cache file of the level, the file is left untouched when it cannot be used
+bool Navigator::LoadCache()
 {
-	if(in_Start->Height || in_Goal->Height || in_Start == in_Goal)
-		return std::numeric_limits<double>::infinity();
-	
-	std::multimap<double, std::shared_ptr<Node>> l_Closed;
-	std::multimap<double, std::shared_ptr<Node>> l_Opened;
-	l_Opened.insert(std::make_pair(0.0, in_Start));
-	std::map<std::shared_ptr<Node>, std::shared_ptr<Node>> l_Parents;
-	l_Parents[in_Start] = std::make_shared<Node>(Node());
-	
-	std::map<std::shared_ptr<Node>, double> l_RealCosts;
-	l_RealCosts[l_Opened.begin()->second] = 0.0;
-	
-	while(!l_Opened.empty())
+	if(m_CachePath.empty())
+		return false;
+
+	try
+	{
+		// The region stays mapped as long as the tables viewing it, the file can be closed
+		boost::interprocess::file_mapping l_File(m_CachePath.c_str(), boost::interprocess::read_only);
+		boost::shared_ptr<boost::interprocess::mapped_region> l_Region(new boost::interprocess::mapped_region(l_File, boost::interprocess::read_only));
+		return ReadCache(l_Region->get_address(), l_Region->get_size(), l_Region);
+	}
+	catch(const boost::interprocess::interprocess_exception &)
 	{
-		std::shared_ptr<Node> l_CurrentNode = l_Opened.begin()->second;
-		l_Closed.insert(*l_Opened.begin());
-		l_Opened.erase(l_Opened.begin());
+		return false;
+	}
+}
 
-		if(l_CurrentNode == in_Goal)
+// Everything is read and checked before the navigator is modified, so a truncated or corrupted file
+// leaves it as LoadLevel built it
+bool Navigator::ReadCache(const void * in_Data, const std::size_t in_Size, const boost::shared_ptr<const void> & in_Mapping)
+{
+	CacheReader l_Reader(in_Data, in_Size, in_Mapping);
+	std::uint32_t l_Magic = 0, l_Version = 0;
+	std::uint64_t l_Fingerprint = 0;
+	if(!l_Reader.Read(l_Magic) || !l_Reader.Read(l_Version) || !l_Reader.Read(l_Fingerprint)
+		|| l_Magic != M_CACHEMAGIC || l_Version != M_CACHEVERSION || l_Fingerprint != m_Fingerprint)
+		return false;
+
+	NodeStore l_Nodes;
+	NodeVector l_AbstractNodes;
+	std::vector<Tiling> l_Tilings;
+	l_Reader.Read(l_Nodes.Levels);
+	l_Reader.Read(l_Nodes.Heights);
+	l_Reader.Read(l_Nodes.X);
+	l_Reader.Read(l_Nodes.Y);
+	l_Reader.Read(l_AbstractNodes);
+	l_Reader.Read(l_Tilings);
+
+	// The abstract levels, the base level is the one built by LoadLevel
+	std::size_t l_NbLevels = 0;
+	l_Reader.ReadCount(l_NbLevels, sizeof(std::uint64_t));
+	std::vector<std::vector<Cluster>> l_Clusters(l_NbLevels);
+	for(auto l_LevelIt = l_Clusters.begin(); l_Reader.Good() && l_LevelIt != l_Clusters.end(); ++l_LevelIt)
+	{
+		std::size_t l_NbClusters = 0;
+		l_Reader.ReadCount(l_NbClusters, 3 * sizeof(int));
+		l_LevelIt->resize(l_NbClusters);
+		for(auto l_It = l_LevelIt->begin(); l_Reader.Good() && l_It != l_LevelIt->end(); ++l_It)
 		{
-			NodeVector l_Path;
-			
-			// Reverse the parents' chain to get the path
-			std::shared_ptr<Node> l_ParentNode = l_Parents[l_CurrentNode];
+			l_Reader.Read(l_It->Level);
+			l_Reader.Read(l_It->Length);
+			l_Reader.Read(l_It->Width);
+			l_Reader.Read(l_It->MinPos);
+			l_Reader.Read(l_It->MaxPos);
+			l_Reader.Read(l_It->BaseNodes);
+			l_Reader.Read(l_It->LevelNodes);
+			l_Reader.Read(l_It->Entrances);
+			l_Reader.Read(l_It->EntranceDistances);
+			l_Reader.Read(l_It->EntrancePaths);
+		}
+	}
 
-			l_Path.push_back(l_CurrentNode);
-			 
-			while(l_ParentNode != in_Start)
-			{
-				l_Path.push_back(l_ParentNode);
-				l_ParentNode = l_Parents[l_ParentNode];
-			}
-			l_Path.push_back(in_Start);
+	std::vector<std::vector<Entrance>> l_Entrances(l_NbLevels);
+	for(auto l_LevelIt = l_Entrances.begin(); l_Reader.Good() && l_LevelIt != l_Entrances.end(); ++l_LevelIt)
+	{
+		std::size_t l_NbEntrances = 0;
+		l_Reader.ReadCount(l_NbEntrances, 2 * sizeof(unsigned));
+		for(std::size_t i = 0; l_Reader.Good() && i < l_NbEntrances; ++i)
+		{
+			std::pair<unsigned, unsigned> l_EntranceClusters;
+			std::vector<Gate> l_Gates;
+			if(l_Reader.Read(l_EntranceClusters) && l_Reader.Read(l_Gates))
+				l_LevelIt->push_back(Entrance(l_EntranceClusters.first, l_EntranceClusters.second, l_Gates));
+		}
+	}
 
-			m_Paths[in_Goal][in_Start] = l_Path;
-			std::reverse(l_Path.begin(), l_Path.end());
-			m_Paths[in_Start][in_Goal] = l_Path;
+	std::vector<std::vector<unsigned>> l_Offsets(l_NbLevels);
+	std::vector<NodeVector> l_Targets(l_NbLevels);
+	std::vector<std::vector<double>> l_Costs(l_NbLevels);
+	for(std::size_t i = 0; l_Reader.Good() && i < l_NbLevels; ++i)
+	{
+		l_Reader.Read(l_Offsets[i]);
+		l_Reader.Read(l_Targets[i]);
+		l_Reader.Read(l_Costs[i]);
+	}
 
-			return l_RealCosts[l_CurrentNode];
-		}
+	MappedArray<float> l_DistanceTable, l_LandmarkDistances;
+	std::vector<unsigned> l_Landmarks;
+	l_Reader.Read(l_DistanceTable);
+	l_Reader.Read(l_Landmarks);
+	l_Reader.Read(l_LandmarkDistances);
+	if(!l_Reader.Read(l_Magic) || l_Magic != M_CACHEMAGIC)
+		return false;
+
+	// The content is checked enough for the searches to stay inside their arrays
+	const unsigned l_NbCells = m_LevelLength * m_LevelWidth;
+	const unsigned l_NbNodes = l_Nodes.Size();
+	auto l_ValidNodes = [l_NbNodes](const NodeVector & in_Nodes)
+	{
+		return std::find_if(in_Nodes.begin(), in_Nodes.end(), [l_NbNodes](const NodeId in_Node) { return in_Node >= l_NbNodes; }) == in_Nodes.end();
+	};
 
-		if(in_Graph[l_CurrentNode] != std::map<std::shared_ptr<Node>, double, NodeComparer>())
+	if(l_NbLevels == 0 || l_NbNodes < l_NbCells || l_Nodes.Heights.size() != l_NbNodes || l_Nodes.X.size() != l_NbNodes 
+		|| l_Nodes.Y.size() != l_NbNodes || l_AbstractNodes.size() != l_NbCells || l_Tilings.size() != l_NbLevels + 1)
+		return false;
+	for(auto l_It = l_AbstractNodes.begin(); l_It != l_AbstractNodes.end(); ++l_It)
+	{
+		if(*l_It != M_NONODE && *l_It >= l_NbNodes)
+			return false;
+	}
+	for(NodeId l_Node = 0; l_Node < l_NbNodes; ++l_Node)
+	{
+		if(l_Nodes.X[l_Node] >= m_LevelWidth || l_Nodes.Y[l_Node] >= m_LevelLength)
+			return false;
+	}
+	// ClusterIndex divides by the size of the clusters and must land inside their level
+	for(auto l_It = l_Tilings.begin(); l_It != l_Tilings.end(); ++l_It)
+	{
+		if(l_It->ClusterLength <= 0 || l_It->ClusterWidth <= 0 || l_It->NbColumns <= 0 || l_It->NbRows <= 0
+			|| l_It->ClusterLength * l_It->NbRows < m_LevelLength || l_It->ClusterWidth * l_It->NbColumns < m_LevelWidth)
+			return false;
+	}
+	for(std::size_t i = 0; i < l_NbLevels; ++i)
+	{
+		if(l_Offsets[i].size() != l_NbNodes + 1 || l_Offsets[i].back() != l_Targets[i].size() || l_Costs[i].size() != l_Targets[i].size()
+			|| !std::is_sorted(l_Offsets[i].begin(), l_Offsets[i].end()) || !l_ValidNodes(l_Targets[i])
+			|| static_cast<std::size_t>(l_Tilings[i + 1].NbColumns * l_Tilings[i + 1].NbRows) != l_Clusters[i].size())
+			return false;
+		for(auto l_It = l_Clusters[i].begin(); l_It != l_Clusters[i].end(); ++l_It)
 		{
-			for(auto l_NeighborIt = in_Graph.at(l_CurrentNode).begin(); l_NeighborIt != in_Graph.at(l_CurrentNode).end(); ++l_NeighborIt)
+			if(!l_ValidNodes(l_It->BaseNodes) || !l_ValidNodes(l_It->LevelNodes) || !l_ValidNodes(l_It->Entrances)
+				|| !ValidCluster(*l_It, i == 0, l_Nodes))
+				return false;
+			if(std::find_if(l_It->EntrancePaths.begin(), l_It->EntrancePaths.end(), [&l_ValidNodes](const NodeVector & in_Path) { return !l_ValidNodes(in_Path); })
+				!= l_It->EntrancePaths.end())
+				return false;
+		}
+		for(auto l_It = l_Entrances[i].begin(); l_It != l_Entrances[i].end(); ++l_It)
+		{
+			if(l_It->Clusters.first >= l_Clusters[i].size() || l_It->Clusters.second >= l_Clusters[i].size())
+				return false;
+			for(auto l_GateIt = l_It->Gates.begin(); l_GateIt != l_It->Gates.end(); ++l_GateIt)
 			{
-				double l_TentativeRealCost = l_RealCosts[l_CurrentNode] + l_NeighborIt->second;
+				if(l_GateIt->first >= l_NbNodes || l_GateIt->second >= l_NbNodes)
+					return false;
+			}
+		}
+	}
 
-				auto l_ClosedNodeIt = std::find_if(l_Closed.begin(), l_Closed.end(), 
-					[&l_NeighborIt](const std::pair<double, std::shared_ptr<Node>> & in_Node)
-				{
-					return *in_Node.second == *l_NeighborIt->first;
-				});
+	std::size_t l_NbEntrances = 0;
+	for(auto l_It = l_Clusters[0].begin(); l_It != l_Clusters[0].end(); ++l_It)
+		l_NbEntrances += l_It->Entrances.size();
+	if(!l_DistanceTable.empty() && l_DistanceTable.size() != l_NbEntrances * l_NbEntrances)
+		return false;
+	if(l_LandmarkDistances.size() != l_Landmarks.size() * l_NbCells 
+		|| std::find_if(l_Landmarks.begin(), l_Landmarks.end(), [l_NbCells](const unsigned in_Cell) { return in_Cell >= l_NbCells; }) != l_Landmarks.end())
+		return false;
+
+	m_Nodes.Swap(l_Nodes);
+	m_AbstractNodes.swap(l_AbstractNodes);
+	m_Tilings.swap(l_Tilings);
+	m_Clusters.resize(l_NbLevels + 1);
+	m_Entrances.swap(l_Entrances);
+	m_Graphs.resize(l_NbLevels + 1);
+	for(std::size_t i = 0; i < l_NbLevels; ++i)
+	{
+		m_Clusters[i + 1].swap(l_Clusters[i]);
+		m_Graphs[i + 1].Assign(l_Offsets[i], l_Targets[i], l_Costs[i]);
+	}
 
-				double l_HeuristicCost = in_Heuristic(*l_NeighborIt->first, *in_Goal);
-				if(l_ClosedNodeIt != l_Closed.end())
-				{
-					if(l_TentativeRealCost + l_HeuristicCost <= l_NeighborIt->second)
-					{
-						l_Opened.insert(*l_ClosedNodeIt);
-						l_Closed.erase(l_ClosedNodeIt);
-					}
-					continue;
-				}
+	m_DistanceTable = std::move(l_DistanceTable);
+	IndexEntrances();
+	m_Landmarks.Assign(m_LevelWidth, l_Landmarks, l_LandmarkDistances);
 
-				auto l_OpenedIt = std::find_if(l_Opened.begin(), l_Opened.end(), 
-					[&l_NeighborIt](const std::pair<double, std::shared_ptr<Node>> & in_Node)
-				{
-					return *in_Node.second == *l_NeighborIt->first;
-				});
+	m_ClusterPaths.assign(m_Clusters[1].size(), ClusterPathsPtr());
+	m_LoadedFromCache = true;
+	return true;
+}
 
-				if(l_OpenedIt != l_Opened.end())
-				{
-					if(l_TentativeRealCost + l_HeuristicCost <= l_NeighborIt->second)
-					{
-						l_Opened.insert(*l_OpenedIt);
-						l_Closed.erase(l_OpenedIt);
-					}
-					continue;
-				}
+// The bounds of a cluster must be inside the level and its tables must have the size its entrances give them. The cells of
+// the first level clusters are indexed by their position, so their base nodes and their entrances must be inside them.
+bool Navigator::ValidCluster(const Cluster & in_Cluster, const bool in_FirstLevel, const NodeStore & in_Nodes) const
+{
+	const int l_MinX = static_cast<int>(in_Cluster.MinPos.x), l_MinY = static_cast<int>(in_Cluster.MinPos.y);
+	if(in_Cluster.Length <= 0 || in_Cluster.Width <= 0 || l_MinX < 0 || l_MinY < 0 
+		|| l_MinX + in_Cluster.Width > m_LevelWidth || l_MinY + in_Cluster.Length > m_LevelLength
+		|| static_cast<int>(in_Cluster.MaxPos.x) != l_MinX + in_Cluster.Width - 1 || static_cast<int>(in_Cluster.MaxPos.y) != l_MinY + in_Cluster.Length - 1)
+		return false;
+
+	const std::size_t l_NbEntrances = in_Cluster.Entrances.size();
+	if(!in_FirstLevel)
+		return in_Cluster.EntranceDistances.size() == l_NbEntrances * l_NbEntrances && in_Cluster.EntrancePaths.size() == l_NbEntrances * l_NbEntrances;
+
+	const std::size_t l_NbCells = static_cast<std::size_t>(in_Cluster.Length) * in_Cluster.Width;
+	if(in_Cluster.BaseNodes.size() != l_NbCells || in_Cluster.EntranceDistances.size() != l_NbEntrances * l_NbCells)
+		return false;
+	return std::find_if(in_Cluster.Entrances.begin(), in_Cluster.Entrances.end(), [&in_Nodes, l_MinX, l_MinY, &in_Cluster](const NodeId in_Node)
+	{
+		return in_Nodes.X[in_Node] < l_MinX || in_Nodes.X[in_Node] >= l_MinX + in_Cluster.Width 
+			|| in_Nodes.Y[in_Node] < l_MinY || in_Nodes.Y[in_Node] >= l_MinY + in_Cluster.Length;
+	}) == in_Cluster.Entrances.end();
+}
 
-				if(l_OpenedIt == l_Opened.end() || l_TentativeRealCost < l_RealCosts[l_NeighborIt->first])
-				{
-					l_Parents[l_NeighborIt->first] = l_CurrentNode;
-					l_RealCosts[l_NeighborIt->first] = l_TentativeRealCost;
-					if(l_OpenedIt == l_Opened.end())
-					{
-						l_Opened.insert(std::make_pair(l_RealCosts[l_NeighborIt->first] + l_HeuristicCost, l_NeighborIt->first));
-					}
-				}
-			}
+// Written to a temporary file first so that a process mapping the cache never sees a partial file. The commanders
+// starting the same level save it at the same time, each writes its own file named after its process and a random number.
+bool Navigator::SaveCache() const
+{
+	if(m_CachePath.empty())
+		return false;
+
+	std::ostringstream l_TempName;
+	l_TempName << m_CachePath << '.' << boost::interprocess::ipcdetail::get_current_process_id() << '.' << std::hex << std::random_device()() << ".tmp";
+	const std::string l_TempPath = l_TempName.str();
+	CacheWriter l_Writer(l_TempPath);
+	l_Writer.Write(M_CACHEMAGIC);
+	l_Writer.Write(M_CACHEVERSION);
+	l_Writer.Write(m_Fingerprint);
+	l_Writer.Write(m_Nodes.Levels);
+	l_Writer.Write(m_Nodes.Heights);
+	l_Writer.Write(m_Nodes.X);
+	l_Writer.Write(m_Nodes.Y);
+	l_Writer.Write(m_AbstractNodes);
+	l_Writer.Write(m_Tilings);
+
+	l_Writer.WriteCount(m_Clusters.size() - 1);
+	for(auto l_LevelIt = m_Clusters.begin() + 1; l_LevelIt != m_Clusters.end(); ++l_LevelIt)
+	{
+		l_Writer.WriteCount(l_LevelIt->size());
+		for(auto l_It = l_LevelIt->begin(); l_It != l_LevelIt->end(); ++l_It)
+		{
+			l_Writer.Write(l_It->Level);
+			l_Writer.Write(l_It->Length);
+			l_Writer.Write(l_It->Width);
+			l_Writer.Write(l_It->MinPos);
+			l_Writer.Write(l_It->MaxPos);
+			l_Writer.Write(l_It->BaseNodes);
+			l_Writer.Write(l_It->LevelNodes);
+			l_Writer.Write(l_It->Entrances);
+			l_Writer.Write(l_It->EntranceDistances);
+			l_Writer.Write(l_It->EntrancePaths);
 		}
 	}
 
-	return std::numeric_limits<double>::infinity();
+	for(auto l_LevelIt = m_Entrances.begin(); l_LevelIt != m_Entrances.end(); ++l_LevelIt)
+	{
+		l_Writer.WriteCount(l_LevelIt->size());
+		for(auto l_It = l_LevelIt->begin(); l_It != l_LevelIt->end(); ++l_It)
+		{
+			l_Writer.Write(l_It->Clusters);
+			l_Writer.Write(l_It->Gates);
+		}
+	}
+
+	for(auto l_It = m_Graphs.begin() + 1; l_It != m_Graphs.end(); ++l_It)
+	{
+		l_Writer.Write(l_It->Offsets());
+		l_Writer.Write(l_It->Targets());
+		l_Writer.Write(l_It->Costs());
+	}
+	l_Writer.Write(m_DistanceTable);
+	l_Writer.Write(m_Landmarks.Cells());
+	l_Writer.Write(m_Landmarks.Distances());
+	l_Writer.Write(M_CACHEMAGIC);
+	l_Writer.Close();
+
+	if(!l_Writer.Good())
+	{
+		std::remove(l_TempPath.c_str());
+		return false;
+	}
+	// rename does not replace an existing file on Windows, it fails when another commander saved the level in between
+	std::remove(m_CachePath.c_str());
+	if(std::rename(l_TempPath.c_str(), m_CachePath.c_str()) == 0)
+		return true;
+	std::remove(l_TempPath.c_str());
+	return std::ifstream(m_CachePath.c_str(), std::ios::in | std::ios::binary).good();
 }
 
-// ********** Offline processing **********
+// There is at most one abstract node per cell so that every search refers to the same index for a given position
+Navigator::NodeId Navigator::GetAbstractNode(const Vector2 & in_Position)
+{
+	NodeId & l_Node = m_AbstractNodes[BaseNode(in_Position)];
+	if(l_Node == M_NONODE)
+		l_Node = m_Nodes.Add(1, 0, in_Position);
+	return l_Node;
+}
 
-void Navigator::AbstractMaze()
+template<class GraphType, class HeuristicType>
+double Navigator::AStar(const NodeId in_Start, const NodeId in_Goal, const GraphType & in_Graph, const HeuristicType & in_Heuristic)
 {
-	BuildClusters(1);
-	auto l_It1 = m_Clusters[1].begin();
-	auto l_It2 = m_Clusters[1].begin() + 1;
-	auto l_End = m_Clusters[1].end();
+	return AStar(in_Start, in_Goal, in_Graph, in_Heuristic, m_SearchContext, m_Statistics);
+}
+
+// The heuristic is a policy of Heuristics.h, a template parameter so that it is inlined in Relax
+template<class GraphType, class HeuristicType>
+double Navigator::AStar(const NodeId in_Start, const NodeId in_Goal, const GraphType & in_Graph, const HeuristicType & in_Heuristic,
+						SearchContext & io_Context, SearchStatistics & io_Statistics) const
+{
+	if(m_Nodes.Heights[in_Start] || m_Nodes.Heights[in_Goal] || in_Start == in_Goal)
+		return std::numeric_limits<double>::infinity();
+
+	++io_Statistics.Searches;
+
+	io_Context.NewSearch();
+	IndexedHeap<double> & l_Opened = io_Context.Opened();
+	const Vector2 l_GoalPos = m_Nodes.Position(in_Goal);
+	io_Context.Open(in_Start, 0.0, SearchContext::M_NOPARENT, in_Heuristic(m_Nodes.Position(in_Start), l_GoalPos));
 	
-	while(l_It1 != l_End)
+	while(!l_Opened.Empty())
+	{
+		const NodeId l_CurrentIndex = l_Opened.Pop();
+		io_Context.Close(l_CurrentIndex);
+		++io_Statistics.Expansions;
+
+		if(l_CurrentIndex == in_Goal)
+			return io_Context.Cost(l_CurrentIndex);
+
+		Expand(l_CurrentIndex, in_Graph, l_GoalPos, in_Heuristic, io_Context);
+	}
+
+	return std::numeric_limits<double>::infinity();
+}
+
+// The edges of the abstract graphs go both ways with the same cost. The searches from both ends order their nodes with opposite
+// average potentials, so they are Dijkstra searches on the same graph with reduced costs: an edge between a node of each search
+// gives a path, and no other path can be shorter once the smallest keys of the two queues add up to the best of these paths
+// (Goldberg & Harrelson, consistent approach). The edge of the best path is written in out_Meeting, the forward search is left
+// in m_SearchContext and the backward one in m_BackwardContext.
+template<class HeuristicType>
+double Navigator::BidirectionalAStar(const NodeId in_Start, const NodeId in_Goal, const CompactGraph & in_Graph, const HeuristicType & in_Heuristic,
+									 std::pair<NodeId, NodeId> & out_Meeting)
+{
+	if(m_Nodes.Heights[in_Start] || m_Nodes.Heights[in_Goal] || in_Start == in_Goal)
+		return std::numeric_limits<double>::infinity();
+
+	++m_Statistics.Searches;
+
+	// Only allocated once a bidirectional search is asked for
+	m_BackwardContext.Resize(m_SearchContext.Capacity());
+	SearchContext * l_Contexts[] = { &m_SearchContext, &m_BackwardContext };
+	const Vector2 l_StartPos = m_Nodes.Position(in_Start), l_GoalPos = m_Nodes.Position(in_Goal);
+	const AveragePotential<HeuristicType> l_Potentials[] = 
+	{ 
+		AveragePotential<HeuristicType>(in_Heuristic, l_StartPos, l_GoalPos), AveragePotential<HeuristicType>(in_Heuristic, l_GoalPos, l_StartPos) 
+	};
+	m_SearchContext.NewSearch();
+	m_SearchContext.Open(in_Start, 0.0, SearchContext::M_NOPARENT, l_Potentials[0](l_StartPos, l_GoalPos));
+	m_BackwardContext.NewSearch();
+	m_BackwardContext.Open(in_Goal, 0.0, SearchContext::M_NOPARENT, l_Potentials[1](l_GoalPos, l_StartPos));
+
+	double l_Best = std::numeric_limits<double>::infinity();
+	IndexedHeap<double> & l_Forward = m_SearchContext.Opened();
+	IndexedHeap<double> & l_Backward = m_BackwardContext.Opened();
+	while(!l_Forward.Empty() && !l_Backward.Empty() && l_Forward.TopKey() + l_Backward.TopKey() < l_Best)
 	{
-		while(l_It2 != l_End)
+		// The smaller frontier grows
+		const unsigned l_Direction = l_Forward.Size() <= l_Backward.Size() ? 0 : 1;
+		SearchContext & l_Context = *l_Contexts[l_Direction];
+		const SearchContext & l_Other = *l_Contexts[1 - l_Direction];
+		const NodeId l_Current = l_Context.Opened().Pop();
+		l_Context.Close(l_Current);
+		++m_Statistics.Expansions;
+
+		auto l_Relax = [&](const NodeId in_Neighbor, const double in_Cost)
 		{
-			Adjacency l_Adjacency;
-			if(Adjacent(*l_It1, *l_It2, l_Adjacency))
+			Relax(l_Current, in_Neighbor, in_Cost, l_Direction ? l_StartPos : l_GoalPos, l_Potentials[l_Direction], l_Context);
+			const double l_Cost = l_Context.Cost(l_Current) + in_Cost + l_Other.Cost(in_Neighbor);
+			if(l_Cost < l_Best)
 			{
-				BuildEntrances(*l_It1, *l_It2, 1, l_Adjacency);
+				l_Best = l_Cost;
+				out_Meeting = l_Direction ? std::make_pair(in_Neighbor, l_Current) : std::make_pair(l_Current, in_Neighbor);
 			}
-			++l_It2;
+		};
+
+		for(unsigned l_Edge = in_Graph.Begin(l_Current), l_End = in_Graph.End(l_Current); l_Edge != l_End; ++l_Edge)
+			l_Relax(in_Graph.Target(l_Edge), in_Graph.Cost(l_Edge));
+
+		if(in_Graph.HasOverlay())
+		{
+			auto l_Overlay = in_Graph.OverlayEdges(l_Current);
+			for(auto l_It = l_Overlay.first; l_It != l_Overlay.second; ++l_It)
+				l_Relax(l_It->To, l_It->Cost);
 		}
-		++l_It1;
-		if(l_It1 != l_End)
-			l_It2 = l_It1 + 1;
 	}
+
+	return l_Best;
+}
+
+template<class GraphType>
+bool Navigator::Dijkstra(const NodeId in_Start, const GraphType & in_Graph)
+{
+	return Dijkstra(in_Start, in_Graph, m_SearchContext, m_Statistics);
+}
+
+// Computes the distance from the start to every node it can reach. The results stay in the search context until its next search.
+// Only the context and the statistics are written so the preprocessing workers can search at the same time.
+template<class GraphType>
+bool Navigator::Dijkstra(const NodeId in_Start, const GraphType & in_Graph, SearchContext & io_Context, SearchStatistics & io_Statistics) const
+{
+	if(m_Nodes.Heights[in_Start])
+		return false;
+
+	++io_Statistics.Searches;
+
+	const TrivialHeuristic l_Heuristic;
+	const Vector2 l_StartPos = m_Nodes.Position(in_Start);
+	io_Context.NewSearch();
+	IndexedHeap<double> & l_Opened = io_Context.Opened();
+	io_Context.Open(in_Start, 0.0, SearchContext::M_NOPARENT, 0.0);
+
+	while(!l_Opened.Empty())
+	{
+		const NodeId l_CurrentIndex = l_Opened.Pop();
+		io_Context.Close(l_CurrentIndex);
+		++io_Statistics.Expansions;
+
+		Expand(l_CurrentIndex, in_Graph, l_StartPos, l_Heuristic, io_Context);
+	}
+
+	return true;
+}
+
+template<class HeuristicType>
+void Navigator::Expand(const NodeId in_Node, const GridGraph::Window & in_Window, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+					   SearchContext & io_Context) const
+{
+	auto l_Relax = [&in_Node, &in_GoalPos, &in_Heuristic, &io_Context, this](const NodeId in_Neighbor, const double in_Cost)
+	{
+		Relax(in_Node, in_Neighbor, in_Cost, in_GoalPos, in_Heuristic, io_Context);
+	};
+	in_Window.Grid->ForEachNeighbor(in_Node, in_Window, l_Relax);
+}
+
+template<class HeuristicType>
+void Navigator::Expand(const NodeId in_Node, const GridGraph::JumpWindow & in_Window, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+					   SearchContext & io_Context) const
+{
+	auto l_Relax = [&in_Node, &in_GoalPos, &in_Heuristic, &io_Context, this](const NodeId in_JumpPoint, const double in_Cost)
+	{
+		Relax(in_Node, in_JumpPoint, in_Cost, in_GoalPos, in_Heuristic, io_Context);
+	};
+	in_Window.Grid->ForEachJumpPoint(in_Node, io_Context.Parent(in_Node), in_Window, l_Relax);
+}
+
+template<class HeuristicType>
+void Navigator::Expand(const NodeId in_Node, const CompactGraph & in_Graph, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+					   SearchContext & io_Context) const
+{
+	for(unsigned l_Edge = in_Graph.Begin(in_Node), l_End = in_Graph.End(in_Node); l_Edge != l_End; ++l_Edge)
+		Relax(in_Node, in_Graph.Target(l_Edge), in_Graph.Cost(l_Edge), in_GoalPos, in_Heuristic, io_Context);
+
+	if(!in_Graph.HasOverlay())
+		return;
+
+	auto l_Overlay = in_Graph.OverlayEdges(in_Node);
+	for(auto l_It = l_Overlay.first; l_It != l_Overlay.second; ++l_It)
+		Relax(in_Node, l_It->To, l_It->Cost, in_GoalPos, in_Heuristic, io_Context);
+}
+
+template<class HeuristicType>
+void Navigator::Expand(const NodeId in_Node, const ClusterGraph & in_Graph, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+					   SearchContext & io_Context) const
+{
+	const CompactGraph & l_Graph = *in_Graph.Graph;
+	for(unsigned l_Edge = l_Graph.Begin(in_Node), l_End = l_Graph.End(in_Node); l_Edge != l_End; ++l_Edge)
+		if(Contains(*in_Graph.Area, l_Graph.Target(l_Edge)))
+			Relax(in_Node, l_Graph.Target(l_Edge), l_Graph.Cost(l_Edge), in_GoalPos, in_Heuristic, io_Context);
+
+	if(!l_Graph.HasOverlay())
+		return;
+
+	auto l_Overlay = l_Graph.OverlayEdges(in_Node);
+	for(auto l_It = l_Overlay.first; l_It != l_Overlay.second; ++l_It)
+		if(Contains(*in_Graph.Area, l_It->To))
+			Relax(in_Node, l_It->To, l_It->Cost, in_GoalPos, in_Heuristic, io_Context);
+}
+
+template<class HeuristicType>
+void Navigator::Relax(const NodeId in_Node, const NodeId in_Neighbor, const double in_Cost, const Vector2 & in_GoalPos, 
+					  const HeuristicType & in_Heuristic, SearchContext & io_Context) const
+{
+	if(io_Context.Closed(in_Neighbor))
+		return;
+
+	double l_TentativeRealCost = io_Context.Cost(in_Node) + in_Cost;
+	if(l_TentativeRealCost >= io_Context.Cost(in_Neighbor))
+		return;
+
+	io_Context.Open(in_Neighbor, l_TentativeRealCost, in_Node, 
+		l_TentativeRealCost + in_Heuristic(m_Nodes.Position(in_Neighbor), in_GoalPos));
+}
+
+void Navigator::ExtractPath(const NodeId in_Goal, NodeVector & out_Path) const
+{
+	ExtractPath(in_Goal, m_SearchContext, out_Path);
+}
+
+// Follows the parents' chain left by the last search of the context. The buffer's memory is reused.
+void Navigator::ExtractPath(const NodeId in_Goal, const SearchContext & in_Context, NodeVector & out_Path) const
+{
+	out_Path.clear();
+	for(NodeId l_Index = in_Goal; l_Index != SearchContext::M_NOPARENT; l_Index = in_Context.Parent(l_Index))
+		out_Path.push_back(l_Index);
+	std::reverse(out_Path.begin(), out_Path.end());
+}
+
+// The forward search gives the path to the first node of the meeting edge, the backward search the path from the second one
+void Navigator::ExtractBidirectionalPath(const std::pair<NodeId, NodeId> & in_Meeting, NodeVector & out_Path) const
+{
+	ExtractPath(in_Meeting.first, m_SearchContext, out_Path);
+	for(NodeId l_Index = in_Meeting.second; l_Index != SearchContext::M_NOPARENT; l_Index = m_BackwardContext.Parent(l_Index))
+		out_Path.push_back(l_Index);
 }
 
-// We assume that a cluster contains all nodes, even the ones representing a block
-// We also assume that we are only gonna call this on the first layer
-bool Navigator::Adjacent(const Cluster & in_Cluster1, const Cluster & in_Cluster2, Adjacency & out_Adjacency) const
+// Follows the jump points left by the last jump point search and adds the cells between them, which are on a straight or a diagonal line
+void Navigator::ExtractJumpPath(const NodeId in_Goal, const SearchContext & in_Context, NodeVector & out_Path)
 {
-	assert(in_Cluster1.Level == in_Cluster2.Level);
-	bool l_Ok = false;
- 
-	// Cluster1 to the right of Cluster2 ?
-	if(in_Cluster1.MinPos.x == in_Cluster2.MaxPos.x+1 && in_Cluster1.MinPos.y == in_Cluster2.MinPos.y)
+	ExtractPath(in_Goal, in_Context, m_JumpPoints);
+	out_Path.clear();
+	out_Path.push_back(m_JumpPoints.front());
+	for(auto l_It = m_JumpPoints.begin() + 1; l_It != m_JumpPoints.end(); ++l_It)
 	{
-		l_Ok = true;
-		out_Adjacency = Right;
+		int l_X = m_Nodes.X[out_Path.back()], l_Y = m_Nodes.Y[out_Path.back()];
+		const int l_JumpX = m_Nodes.X[*l_It], l_JumpY = m_Nodes.Y[*l_It];
+		while(l_X != l_JumpX || l_Y != l_JumpY)
+		{
+			l_X += (l_JumpX > l_X) - (l_JumpX < l_X);
+			l_Y += (l_JumpY > l_Y) - (l_JumpY < l_Y);
+			out_Path.push_back(l_X + l_Y * m_LevelWidth);
+		}
 	}
-	// Cluster1 below Cluster2 ?
-	else if(in_Cluster1.MinPos.y == in_Cluster2.MaxPos.y+1 && in_Cluster1.MinPos.x == in_Cluster2.MinPos.x)
+}
+
+// Shortest path between two base nodes of a cluster with the selected search, the path is left in m_PathBuffer
+double Navigator::SearchCluster(const NodeId in_Start, const NodeId in_Goal, const Cluster & in_Cluster)
+{
+	if(!SameComponent(m_ClusterComponents, in_Start, in_Goal))
+		return std::numeric_limits<double>::infinity();
+
+	if(m_ClusterSearch == JumpPointSearch)
 	{
-		l_Ok = true;
-		out_Adjacency = Below;
+		const double l_Cost = AStar(in_Start, in_Goal, GridGraph::JumpWindow(ClusterWindow(in_Cluster), in_Goal), MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Landmarks)));
+		if(l_Cost < std::numeric_limits<double>::infinity())
+			ExtractJumpPath(in_Goal, m_SearchContext, m_PathBuffer);
+		return l_Cost;
 	}
-	// Cluster1 to left of Cluster2 ?
-	else if(in_Cluster1.MaxPos.x == in_Cluster2.MinPos.x-1 && in_Cluster1.MinPos.y == in_Cluster2.MinPos.y)
+
+	const double l_Cost = AStar(in_Start, in_Goal, ClusterWindow(in_Cluster), TrivialHeuristic());
+	if(l_Cost < std::numeric_limits<double>::infinity())
+		ExtractPath(in_Goal, m_PathBuffer);
+	return l_Cost;
+}
+
+// Jump point search on the whole grid, the search is left in m_FlatContext. This does not touch anything the background worker builds.
+double Navigator::SearchFlat(const NodeId in_Start, const NodeId in_Goal)
+{
+	if(!SameComponent(m_Components, in_Start, in_Goal))
+		return std::numeric_limits<double>::infinity();
+	return AStar(in_Start, in_Goal, GridGraph::JumpWindow(m_Grid.Whole(), in_Goal), OctileDistance(), m_FlatContext, m_FlatStatistics);
+}
+
+EncodedPath Navigator::EncodePath(const NodeVector & in_Path) const
+{
+	EncodedPath l_Path(m_Nodes.X[in_Path.front()], m_Nodes.Y[in_Path.front()]);
+	l_Path.Reserve(static_cast<unsigned>(in_Path.size() - 1));
+	for(auto l_It = in_Path.begin() + 1; l_It != in_Path.end(); ++l_It)
+		l_Path.Append(m_Nodes.X[*l_It], m_Nodes.Y[*l_It]);
+	return l_Path;
+}
+
+// ********** Offline processing **********
+
+unsigned Navigator::GetWorkerCount() const
+{
+	return m_NbWorkers ? m_NbWorkers : std::max(boost::thread::hardware_concurrency(), 1u);
+}
+
+unsigned Navigator::WorkersFor(const unsigned in_NbTasks) const
+{
+	return std::max(std::min(GetWorkerCount(), in_NbTasks), 1u);
+}
+
+// Gives a search context to every worker but the calling thread, which works with the Navigator's context
+unsigned Navigator::PrepareWorkers(const unsigned in_NbTasks)
+{
+	const unsigned l_NbWorkers = WorkersFor(in_NbTasks);
+	m_WorkerContexts.resize(l_NbWorkers - 1);
+	for(auto l_It = m_WorkerContexts.begin(); l_It != m_WorkerContexts.end(); ++l_It)
+		l_It->Resize(m_SearchContext.Capacity());
+	return l_NbWorkers;
+}
+
+// Calls in_Func(cluster, context, statistics) for every cluster on the preprocessing workers. A call must only write its own cluster.
+template<class Op>
+void Navigator::ForEachClusterParallel(std::vector<Cluster> & io_Clusters, Op in_Func)
+{
+	const unsigned l_NbWorkers = PrepareWorkers(static_cast<unsigned>(io_Clusters.size()));
+	ForEachClusterOnWorkers(io_Clusters, l_NbWorkers, [&in_Func, this](Cluster & io_Cluster, const unsigned in_Worker, SearchStatistics & io_Statistics)
 	{
-		l_Ok = true;
-		out_Adjacency = Left;
+		in_Func(io_Cluster, in_Worker ? m_WorkerContexts[in_Worker - 1] : m_SearchContext, io_Statistics);
+	});
+}
+
+// Calls in_Func(cluster, worker, statistics) for every cluster on in_NbWorkers workers and adds up their statistics
+template<class Op>
+void Navigator::ForEachClusterOnWorkers(std::vector<Cluster> & io_Clusters, const unsigned in_NbWorkers, Op in_Func)
+{
+	std::vector<SearchStatistics> l_Statistics(in_NbWorkers);
+	ParallelFor(static_cast<unsigned>(io_Clusters.size()), in_NbWorkers, [&io_Clusters, &in_Func, &l_Statistics](const unsigned in_Index, const unsigned in_Worker)
+	{
+		in_Func(io_Clusters[in_Index], in_Worker, l_Statistics[in_Worker]);
+	});
+
+	for(auto l_It = l_Statistics.begin(); l_It != l_Statistics.end(); ++l_It)
+	{
+		m_Statistics.Searches += l_It->Searches;
+		m_Statistics.Expansions += l_It->Expansions;
 	}
-	// Cluster1 above Cluster2 ?
-	else if(in_Cluster1.MaxPos.y == in_Cluster2.MinPos.y-1 && in_Cluster1.MinPos.x == in_Cluster2.MinPos.x)
+}
+
+// Entrances are only built between a cluster and its right and bottom neighbors, in the order of the clusters
+void Navigator::AbstractMaze()
+{
+	BuildClusters(1);
+	const Tiling & l_Tiling = m_Tilings[1];
+	std::vector<Cluster> & l_Clusters = m_Clusters[1];
+
+	for(unsigned i = 0; i < l_Clusters.size(); ++i)
 	{
-		l_Ok = true;
-		out_Adjacency = Above;
+		if(static_cast<int>(i % l_Tiling.NbColumns) + 1 < l_Tiling.NbColumns)
+			BuildEntrances(l_Clusters[i], l_Clusters[i + 1], 1, Left);
+		if(static_cast<int>(i / l_Tiling.NbColumns) + 1 < l_Tiling.NbRows)
+			BuildEntrances(l_Clusters[i], l_Clusters[i + l_Tiling.NbColumns], 1, Above);
 	}
+}
+
+// Labels the whole grid, then each cluster of the first level on its own
+void Navigator::LabelComponents()
+{
+	const unsigned l_NbCells = m_LevelLength * m_LevelWidth;
+	m_Components.assign(l_NbCells, static_cast<unsigned>(GridGraph::M_NOCOMPONENT));
+	m_ClusterComponents.assign(l_NbCells, static_cast<unsigned>(GridGraph::M_NOCOMPONENT));
+	m_Grid.LabelComponents(m_Grid.Whole(), m_Components);
+
+	const int l_ClusterLength = ClusterSize(m_LevelLength);
+	const int l_ClusterWidth = ClusterSize(m_LevelWidth);
+	for(int y = 0; y < m_LevelLength; y += l_ClusterLength)
+		for(int x = 0; x < m_LevelWidth; x += l_ClusterWidth)
+			m_Grid.LabelComponents(GridGraph::Window(m_Grid, x, y, x + l_ClusterWidth - 1, y + l_ClusterLength - 1), m_ClusterComponents);
+}
+
+bool Navigator::SameComponent(const std::vector<unsigned> & in_Components, const NodeId in_BaseNode1, const NodeId in_BaseNode2)
+{
+	return in_Components[in_BaseNode1] != GridGraph::M_NOCOMPONENT && in_Components[in_BaseNode1] == in_Components[in_BaseNode2];
+}
+
+unsigned Navigator::AddFlowGoal(const Vector2 & in_Goal)
+{
+	m_FlowGoals.push_back(in_Goal);
+	return static_cast<unsigned>(m_FlowGoals.size() - 1);
+}
+
+// The fields are published with the hierarchy
+const FlowField * Navigator::GetFlowField(const unsigned in_Goal) const
+{
+	if(!IsHierarchyReady() || in_Goal >= m_FlowFields.size())
+		return nullptr;
+	return &m_FlowFields[in_Goal];
+}
 
-	return l_Ok;
+bool Navigator::GetFlowPath(const unsigned in_Goal, const Vector2 & in_Start, std::vector<Vector2> & out_Path) const
+{
+	const FlowField * l_Field = GetFlowField(in_Goal);
+	return l_Field && l_Field->Descend(BaseNode(LevelCell(in_Start)), out_Path);
+}
+
+bool Navigator::GetFlowWaypoint(const unsigned in_Goal, const Vector2 & in_Position, Vector2 & out_Waypoint) const
+{
+	const FlowField * l_Field = GetFlowField(in_Goal);
+	const NodeId l_Cell = BaseNode(LevelCell(in_Position));
+	if(!l_Field || !l_Field->Reached(l_Cell))
+		return false;
+
+	out_Waypoint = m_Nodes.Position(l_Field->Next(l_Cell));
+	return true;
+}
+
+double Navigator::GetFlowDistance(const unsigned in_Goal, const Vector2 & in_Position) const
+{
+	const FlowField * l_Field = GetFlowField(in_Goal);
+	return l_Field ? l_Field->Distance(BaseNode(LevelCell(in_Position))) : std::numeric_limits<double>::infinity();
+}
+
+void Navigator::ComputeDistanceLayers(const std::vector<Vector2> & in_Sources, std::vector<std::vector<unsigned short>> & out_Layers)
+{
+	NodeVector l_Sources;
+	l_Sources.reserve(in_Sources.size());
+	for(auto l_It = in_Sources.begin(); l_It != in_Sources.end(); ++l_It)
+		l_Sources.push_back(BaseNode(LevelCell(*l_It)));
+
+	if(m_WavefrontKernel == SimdWavefront)
+		m_Wavefront.Run<Sse2Lanes>(m_Grid, l_Sources, out_Layers);
+	else
+		m_Wavefront.Run<ScalarLanes>(m_Grid, l_Sources, out_Layers);
+}
+
+bool Navigator::Reachable(const Vector2 & in_Start, const Vector2 & in_Goal) const
+{
+	return SameComponent(m_Components, BaseNode(LevelCell(in_Start)), BaseNode(LevelCell(in_Goal)));
 }
 
 int Navigator::ClusterSize(const int in_Size) const
@@ -227,52 +894,18 @@ int Navigator::ClusterSize(const int in_Size) const
 	return l_ClusterSize;
 }
 
-void Navigator::BuildLocalGraph(const int in_Length, const int in_Width, const Navigator::NodeVector & in_Nodes, Graph & out_LocalGraph)
+// Searches between base nodes of a cluster are not allowed to leave it
+GridGraph::Window Navigator::ClusterWindow(const Cluster & in_Cluster) const
 {
-	int l_CurrentNodeIndex = 0;	
-	int l_RightNodeIndex = 0;
-	int l_DownRightIndex = 0;
-	int l_DownIndex = 0;
-	int l_DownLeftIndex = 0;
+	return GridGraph::Window(m_Grid, static_cast<int>(in_Cluster.MinPos.x), static_cast<int>(in_Cluster.MinPos.y), 
+		static_cast<int>(in_Cluster.MaxPos.x), static_cast<int>(in_Cluster.MaxPos.y));
+}
 
-	for(int i  = 0; i < in_Length; ++i)
-	{
-		for(int j = 0; j < in_Width; ++j)
-		{
-			l_CurrentNodeIndex = j + i * in_Width;
-			l_RightNodeIndex = l_CurrentNodeIndex+1;
-			l_DownRightIndex = (j+1) + (i+1) * in_Width;
-			l_DownIndex = j + (i+1) * in_Width;
-			l_DownLeftIndex = (j-1) + (i+1) * in_Width;
-			if(!in_Nodes[l_CurrentNodeIndex]->Height)
-			{
-				// Link the right node
-				if(j < in_Width-1 && !in_Nodes[l_CurrentNodeIndex+1]->Height)
-				{
-					out_LocalGraph[in_Nodes[l_CurrentNodeIndex]][in_Nodes[l_RightNodeIndex]] = 1.0;
-					out_LocalGraph[in_Nodes[l_RightNodeIndex]][in_Nodes[l_CurrentNodeIndex]] = 1.0;
-				}
-				// Link the down-right node
-				if(j < in_Width-1 && i < in_Length-1 && !in_Nodes[l_DownRightIndex]->Height)
-				{
-					out_LocalGraph[in_Nodes[l_CurrentNodeIndex]][in_Nodes[l_DownRightIndex]] = 1.42;
-					out_LocalGraph[in_Nodes[l_DownRightIndex]][in_Nodes[l_CurrentNodeIndex]] = 1.42;
-				}
-				// Link the down node
-				if(i < in_Length-1 && !in_Nodes[l_DownIndex]->Height)
-				{
-					out_LocalGraph[in_Nodes[l_CurrentNodeIndex]][in_Nodes[l_DownIndex]] = 1.0;
-					out_LocalGraph[in_Nodes[l_DownIndex]][in_Nodes[l_CurrentNodeIndex]] = 1.0;
-				}
-				// Link the down-left node
-				if(j > 0 && i < in_Length-1 && !in_Nodes[l_DownLeftIndex]->Height)
-				{
-					out_LocalGraph[in_Nodes[l_CurrentNodeIndex]][in_Nodes[l_DownLeftIndex]] = 1.42;
-					out_LocalGraph[in_Nodes[l_DownLeftIndex]][in_Nodes[l_CurrentNodeIndex]] = 1.42;
-				}
-			}
-		}
-	}
+// The base nodes of a cluster are stored row by row, so this is also the index of the cell's base node in the cluster
+unsigned Navigator::CellInCluster(const Cluster & in_Cluster, const NodeId in_Node) const
+{
+	return (m_Nodes.X[in_Node] - static_cast<int>(in_Cluster.MinPos.x)) 
+		+ (m_Nodes.Y[in_Node] - static_cast<int>(in_Cluster.MinPos.y)) * in_Cluster.Width;
 }
 
 void Navigator::BuildClusters(const int in_Level)
@@ -282,6 +915,7 @@ void Navigator::BuildClusters(const int in_Level)
 
 	int l_ClusterLength = ClusterSize(l_Length);
 	int l_ClusterWidth = ClusterSize(l_Width);
+	m_Tilings.push_back(Tiling(l_ClusterLength, l_ClusterWidth, l_Width / l_ClusterWidth, l_Length / l_ClusterLength));
 
 	m_Clusters.push_back(std::vector<Cluster>(
 		(l_Length / l_ClusterLength) * (l_Width / l_ClusterWidth),
@@ -309,9 +943,143 @@ void Navigator::BuildClusters(const int in_Level)
 			l_WidthOffset = 0;
 			l_LengthOffset += l_ClusterLength;
 		}
-		auto l_MinMax = std::minmax_element(l_It->BaseNodes.begin(), l_It->BaseNodes.end(), PositionComparer());
-		l_It->MinPos = (*l_MinMax.first)->Position;
-		l_It->MaxPos = (*l_MinMax.second)->Position;
+		// The base nodes are stored row by row so the corners are at both ends
+		l_It->MinPos = m_Nodes.Position(l_It->BaseNodes.front());
+		l_It->MaxPos = m_Nodes.Position(l_It->BaseNodes.back());
+	}
+}
+
+// Only a few clusters are left on the top level, or the depth that was asked for is reached
+bool Navigator::NeedsUpperLevel() const
+{
+	if(m_Tilings.back().NbColumns == 1 && m_Tilings.back().NbRows == 1)
+		return false;
+	return m_MaxDepth ? GetDepth() < m_MaxDepth : m_Clusters.back().size() > M_MAXTOPCLUSTERS;
+}
+
+// Groups the clusters of the level below by squares of M_CLUSTERGROUPSIZE. Only the bounds of the upper clusters are kept.
+void Navigator::BuildUpperClusters(const int in_Level)
+{
+	const Tiling & l_Lower = m_Tilings[in_Level - 1];
+	const Tiling l_Tiling(l_Lower.ClusterLength * M_CLUSTERGROUPSIZE, l_Lower.ClusterWidth * M_CLUSTERGROUPSIZE,
+		(l_Lower.NbColumns + M_CLUSTERGROUPSIZE - 1) / M_CLUSTERGROUPSIZE, (l_Lower.NbRows + M_CLUSTERGROUPSIZE - 1) / M_CLUSTERGROUPSIZE);
+	const int l_Length = m_Clusters[0].begin()->Length;
+	const int l_Width = m_Clusters[0].begin()->Width;
+
+	m_Tilings.push_back(l_Tiling);
+	m_Clusters.push_back(std::vector<Cluster>());
+	m_Clusters[in_Level].reserve(l_Tiling.NbColumns * l_Tiling.NbRows);
+	for(int l_Row = 0; l_Row < l_Tiling.NbRows; ++l_Row)
+	{
+		for(int l_Column = 0; l_Column < l_Tiling.NbColumns; ++l_Column)
+		{
+			const int l_MinX = l_Column * l_Tiling.ClusterWidth;
+			const int l_MinY = l_Row * l_Tiling.ClusterLength;
+			const int l_MaxX = std::min(l_MinX + l_Tiling.ClusterWidth, l_Width) - 1;
+			const int l_MaxY = std::min(l_MinY + l_Tiling.ClusterLength, l_Length) - 1;
+
+			Cluster l_Cluster(in_Level, l_MaxY - l_MinY + 1, l_MaxX - l_MinX + 1);
+			l_Cluster.MinPos = Vector2(static_cast<float>(l_MinX), static_cast<float>(l_MinY));
+			l_Cluster.MaxPos = Vector2(static_cast<float>(l_MaxX), static_cast<float>(l_MaxY));
+			m_Clusters[in_Level].push_back(std::move(l_Cluster));
+		}
+	}
+}
+
+// The gates of an upper level are the gates of the level below that cross the border of its clusters
+void Navigator::BuildUpperEntrances(const int in_Level)
+{
+	std::map<std::pair<unsigned, unsigned>, std::vector<Gate>> l_Gates;
+	std::vector<Cluster> & l_Clusters = m_Clusters[in_Level];
+
+	for(auto l_It = m_Entrances[in_Level - 2].begin(); l_It != m_Entrances[in_Level - 2].end(); ++l_It)
+	{
+		for(auto l_GateIt = l_It->Gates.begin(); l_GateIt != l_It->Gates.end(); ++l_GateIt)
+		{
+			const unsigned l_Cluster1 = ClusterIndex(m_Nodes.Position(l_GateIt->first), in_Level);
+			const unsigned l_Cluster2 = ClusterIndex(m_Nodes.Position(l_GateIt->second), in_Level);
+			if(l_Cluster1 == l_Cluster2)
+				continue;
+
+			l_Gates[std::make_pair(l_Cluster1, l_Cluster2)].push_back(*l_GateIt);
+			m_Nodes.Levels[l_GateIt->first] = m_Nodes.Levels[l_GateIt->second] = static_cast<unsigned char>(in_Level);
+			l_Clusters[l_Cluster1].LevelNodes.push_back(l_GateIt->first);
+			l_Clusters[l_Cluster2].LevelNodes.push_back(l_GateIt->second);
+		}
+	}
+
+	m_Entrances.push_back(std::vector<Entrance>());
+	for(auto l_It = l_Gates.begin(); l_It != l_Gates.end(); ++l_It)
+		m_Entrances[in_Level - 1].push_back(Entrance(l_It->first.first, l_It->first.second, l_It->second));
+
+	for(auto l_It = l_Clusters.begin(); l_It != l_Clusters.end(); ++l_It)
+	{
+		std::sort(l_It->LevelNodes.begin(), l_It->LevelNodes.end());
+		l_It->LevelNodes.erase(std::unique(l_It->LevelNodes.begin(), l_It->LevelNodes.end()), l_It->LevelNodes.end());
+		l_It->Entrances = l_It->LevelNodes;
+	}
+}
+
+// The entrances of an upper cluster are linked by their distance on the level below, without leaving the cluster
+void Navigator::BuildUpperGraph(const int in_Level)
+{
+	Graph l_Graph;
+
+	std::for_each(m_Entrances[in_Level - 1].begin(), m_Entrances[in_Level - 1].end(), [&l_Graph](const Entrance & in_Entrance)
+	{
+		for(auto l_GatesIt = in_Entrance.Gates.begin(); l_GatesIt != in_Entrance.Gates.end(); ++l_GatesIt)
+		{
+			l_Graph[l_GatesIt->first][l_GatesIt->second] = 1.0;
+			l_Graph[l_GatesIt->second][l_GatesIt->first] = 1.0;
+		}
+	});
+
+	ForEachClusterParallel(m_Clusters[in_Level], [this](Cluster & io_Cluster, SearchContext & io_Context, SearchStatistics & io_Statistics)
+	{
+		BuildUpperPaths(io_Cluster, io_Context, io_Statistics);
+	});
+
+	for(auto l_ClusterIt = m_Clusters[in_Level].begin(); l_ClusterIt != m_Clusters[in_Level].end(); ++l_ClusterIt)
+	{
+		const NodeVector & l_Entrances = l_ClusterIt->Entrances;
+		for(unsigned i = 0; i + 1 < l_Entrances.size(); ++i)
+		{
+			for(unsigned j = i + 1; j < l_Entrances.size(); ++j)
+			{
+				const double l_Distance = l_ClusterIt->EntranceDistances[i * l_Entrances.size() + j];
+				if(l_Distance < std::numeric_limits<double>::infinity())
+				{
+					l_Graph[l_Entrances[i]][l_Entrances[j]] = l_Distance;
+					l_Graph[l_Entrances[j]][l_Entrances[i]] = l_Distance;
+				}
+			}
+		}
+	}
+
+	m_Graphs.push_back(CompactGraph());
+	m_Graphs[in_Level].Build(l_Graph, m_Nodes.Size());
+}
+
+// One search on the level below from each entrance of an upper cluster gives its distance and its path to the entrances after it
+void Navigator::BuildUpperPaths(Cluster & io_Cluster, SearchContext & io_Context, SearchStatistics & io_Statistics) const
+{
+	const NodeVector & l_Entrances = io_Cluster.Entrances;
+	std::vector<double> & l_Distances = io_Cluster.EntranceDistances.Owned();
+	l_Distances.assign(l_Entrances.size() * l_Entrances.size(), std::numeric_limits<double>::infinity());
+	io_Cluster.EntrancePaths.resize(l_Entrances.size() * l_Entrances.size());
+	for(unsigned i = 0; i + 1 < l_Entrances.size(); ++i)
+	{
+		if(!Dijkstra(l_Entrances[i], ClusterGraph(m_Graphs[io_Cluster.Level - 1], io_Cluster), io_Context, io_Statistics))
+			continue;
+
+		for(unsigned j = i + 1; j < l_Entrances.size(); ++j)
+		{
+			if(io_Context.Closed(l_Entrances[j]))
+			{
+				l_Distances[i * l_Entrances.size() + j] = io_Context.Cost(l_Entrances[j]);
+				ExtractPath(l_Entrances[j], io_Context, io_Cluster.EntrancePaths[i * l_Entrances.size() + j]);
+			}
+		}
 	}
 }
 
@@ -320,7 +1088,7 @@ void Navigator::BuildEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2, con
 	assert(in_Cluster1.Length == in_Cluster2.Length);
 	assert(in_Cluster1.Width == in_Cluster2.Width);
 
-	std::vector<std::pair<std::shared_ptr<Node>, std::shared_ptr<Node>>> l_Gates;
+	std::vector<Gate> l_Gates;
 
 	// Describe the relationship between Cluster1 & Cluster2
 	switch (in_Adjacency)
@@ -341,7 +1109,9 @@ void Navigator::BuildEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2, con
 			break;
 	}
 
-	m_Entrances[in_Level-1].push_back(Entrance(in_Cluster1, in_Cluster2, l_Gates));
+	const Cluster * l_First = &m_Clusters[in_Level].front();
+	m_Entrances[in_Level-1].push_back(Entrance(static_cast<unsigned>(&in_Cluster1 - l_First), 
+		static_cast<unsigned>(&in_Cluster2 - l_First), l_Gates));
 	// Removing duplicates in LevelNodes
 	std::sort(in_Cluster1.LevelNodes.begin(), in_Cluster1.LevelNodes.end());
 	std::sort(in_Cluster2.LevelNodes.begin(), in_Cluster2.LevelNodes.end());
@@ -358,43 +1128,19 @@ void Navigator::BuildSideEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2,
 	{
 		int l_Index1 = (i+1) * in_Cluster1.Width - 1;
 		int l_Index2 = in_Cluster2.Width * i;
-		if(in_Cluster1.BaseNodes[l_Index1]->Height 
-			|| in_Cluster2.BaseNodes[l_Index2]->Height)
+		if(m_Nodes.Heights[in_Cluster1.BaseNodes[l_Index1]] 
+			|| m_Nodes.Heights[in_Cluster2.BaseNodes[l_Index2]])
 		{
 			++j;
 		}
 		else
 		{
-			l_PotentialGates[j].push_back(std::make_pair(
-				std::make_shared<Node>(Node(in_Cluster1.Level, 0, in_Cluster1.BaseNodes[l_Index1]->Position)),
-				std::make_shared<Node>(Node(in_Cluster2.Level, 0, in_Cluster2.BaseNodes[l_Index2]->Position))));
+			l_PotentialGates[j].push_back(std::make_pair(in_Cluster1.BaseNodes[l_Index1], in_Cluster2.BaseNodes[l_Index2]));
 		}
 	}
 
-	for(int i = 0; i <= j; ++i)
-	{
-		if(l_PotentialGates[i].size() == m_MaxEntranceWidth && l_PotentialGates[i].size() > 0)
-		{
-			out_Gates.push_back(l_PotentialGates[i][l_PotentialGates[i].size()/2]);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()/2].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()/2].second);
-		}
-		else if(l_PotentialGates[i].size() < m_MaxEntranceWidth && l_PotentialGates[i].size() > 0)
-		{
-			out_Gates.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1]);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].second);
-		}
-		else if(l_PotentialGates[i].size() > m_MaxEntranceWidth && l_PotentialGates[i].size() > 0)
-		{
-			out_Gates.push_back(l_PotentialGates[i][0]);
-			out_Gates.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1]);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][0].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][0].second);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].second);
-		}
-	}
+	l_PotentialGates.resize(j+1);
+	SelectGates(in_Cluster1, in_Cluster2, l_PotentialGates, out_Gates);
 }
 
 void Navigator::BuildTopEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2, std::vector<Gate> & out_Gates)
@@ -406,152 +1152,471 @@ void Navigator::BuildTopEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2,
 	for(int i = 0; i < in_Cluster1.Width; ++i)
 	{
 		l_Index1 = in_Cluster1.Width*(in_Cluster1.Length-1)+i;
-		if(in_Cluster1.BaseNodes[l_Index1]->Height 
-			|| in_Cluster2.BaseNodes[i]->Height)
+		if(m_Nodes.Heights[in_Cluster1.BaseNodes[l_Index1]] 
+			|| m_Nodes.Heights[in_Cluster2.BaseNodes[i]])
 		{
 			++j;
 		}
 		else
 		{
-			l_PotentialGates[j].push_back(std::make_pair(
-				std::make_shared<Node>(Node(in_Cluster1.Level, 0, in_Cluster1.BaseNodes[l_Index1]->Position)),
-				 std::make_shared<Node>(Node(in_Cluster2.Level, 0, in_Cluster2.BaseNodes[i]->Position))));
+			l_PotentialGates[j].push_back(std::make_pair(in_Cluster1.BaseNodes[l_Index1], in_Cluster2.BaseNodes[i]));
 		}
 	}
 
-	for(int i = 0; i <= j; ++i)
+	l_PotentialGates.resize(j+1);
+	SelectGates(in_Cluster1, in_Cluster2, l_PotentialGates, out_Gates);
+}
+
+// The potential gates are pairs of base nodes, only the selected ones get an abstract node
+void Navigator::SelectGates(Cluster & in_Cluster1, Cluster & in_Cluster2, const std::vector<std::vector<Gate>> & in_PotentialGates, 
+							std::vector<Gate> & out_Gates)
+{
+	for(auto l_It = in_PotentialGates.begin(); l_It != in_PotentialGates.end(); ++l_It)
 	{
-		if(l_PotentialGates[i].size() == m_MaxEntranceWidth && l_PotentialGates[i].size() > 0)
+		if(l_It->empty())
+			continue;
+
+		if(l_It->size() == m_MaxEntranceWidth)
 		{
-			out_Gates.push_back(l_PotentialGates[i][l_PotentialGates[i].size()/2]);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()/2].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()/2].second);
+			AddGate(in_Cluster1, in_Cluster2, (*l_It)[l_It->size()/2], out_Gates);
 		}
-		else if(l_PotentialGates[i].size() < m_MaxEntranceWidth && l_PotentialGates[i].size() > 0)
+		else if(l_It->size() < m_MaxEntranceWidth)
 		{
-			out_Gates.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1]);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].second);
+			AddGate(in_Cluster1, in_Cluster2, l_It->back(), out_Gates);
 		}
-		else if(l_PotentialGates[i].size() > m_MaxEntranceWidth && l_PotentialGates[i].size() > 0)
+		else
 		{
-			out_Gates.push_back(l_PotentialGates[i][0]);
-			out_Gates.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1]);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][0].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][0].second);
-			in_Cluster1.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].first);
-			in_Cluster2.LevelNodes.push_back(l_PotentialGates[i][l_PotentialGates[i].size()-1].second);
+			AddGate(in_Cluster1, in_Cluster2, l_It->front(), out_Gates);
+			AddGate(in_Cluster1, in_Cluster2, l_It->back(), out_Gates);
 		}
 	}
 }
 
+void Navigator::AddGate(Cluster & in_Cluster1, Cluster & in_Cluster2, const Gate & in_BaseGate, std::vector<Gate> & out_Gates)
+{
+	Gate l_Gate(GetAbstractNode(m_Nodes.Position(in_BaseGate.first)), GetAbstractNode(m_Nodes.Position(in_BaseGate.second)));
+	out_Gates.push_back(l_Gate);
+	in_Cluster1.LevelNodes.push_back(l_Gate.first);
+	in_Cluster2.LevelNodes.push_back(l_Gate.second);
+}
+
 void Navigator::BuildGraph()
 {
-	m_Graphs.push_back(Graph());
+	Graph l_Graph;
 
-	std::for_each(m_Entrances[0].begin(), m_Entrances[0].end(), [this](const Entrance & in_Entrance)
+	std::for_each(m_Entrances[0].begin(), m_Entrances[0].end(), [&l_Graph](const Entrance & in_Entrance)
 	{
 		for(auto l_GatesIt = in_Entrance.Gates.begin(); l_GatesIt != in_Entrance.Gates.end(); ++l_GatesIt)
 		{
 			// Gate transitions always cost 1
-			m_Graphs[1][l_GatesIt->first][l_GatesIt->second] = 1.0;
-			m_Graphs[1][l_GatesIt->second][l_GatesIt->first] = 1.0;
+			l_Graph[l_GatesIt->first][l_GatesIt->second] = 1.0;
+			l_Graph[l_GatesIt->second][l_GatesIt->first] = 1.0;
 		}
 	});
 
-	std::for_each(m_Clusters[1].begin(), m_Clusters[1].end(), [this](Cluster & in_Cluster)
+	ConnectLevelNodes(l_Graph);
+
+	// The abstract graph does not change anymore, only the queries' edges are added to its overlay
+	m_Graphs.push_back(CompactGraph());
+	m_Graphs[1].Build(l_Graph, m_Nodes.Size());
+}
+
+// Calls io_Op(search) with the search specialised for the smallest size that holds the cluster. The grid is 8-connected
+// and the clusters of the first level are never larger than M_MAXCLUSTERSIZE.
+template<class Op>
+void Navigator::WithFixedSearch(const Cluster & in_Cluster, Op & io_Op) const
+{
+	if(FixedClusterSearch<8, true>::Fits(in_Cluster.Length, in_Cluster.Width))
 	{
-		BuildLocalGraph(in_Cluster.Length, in_Cluster.Width, in_Cluster.BaseNodes, in_Cluster.LocalGraph);
-	});
+		FixedClusterSearch<8, true> l_Search;
+		io_Op(l_Search);
+	}
+	else if(FixedClusterSearch<16, true>::Fits(in_Cluster.Length, in_Cluster.Width))
+	{
+		FixedClusterSearch<16, true> l_Search;
+		io_Op(l_Search);
+	}
+	else
+	{
+		FixedClusterSearch<M_MAXCLUSTERSIZE, true> l_Search;
+		io_Op(l_Search);
+	}
+}
+
+void Navigator::BuildEntranceDistances(Cluster & io_Cluster, SearchStatistics & io_Statistics) const
+{
+	EntranceDistancesTask l_Task(*this, io_Cluster, io_Statistics);
+	WithFixedSearch(io_Cluster, l_Task);
+}
+
+// One search from each entrance gives its distance to every cell of the cluster
+template<class SearchType>
+void Navigator::BuildEntranceDistances(Cluster & io_Cluster, SearchType & io_Search, SearchStatistics & io_Statistics) const
+{
+	const unsigned l_NbCells = io_Cluster.Length * io_Cluster.Width;
+	io_Cluster.Entrances = io_Cluster.LevelNodes;
+	std::vector<double> & l_Distances = io_Cluster.EntranceDistances.Owned();
+	l_Distances.assign(io_Cluster.Entrances.size() * l_NbCells, std::numeric_limits<double>::infinity());
+	io_Search.Load(m_Grid, static_cast<int>(io_Cluster.MinPos.x), static_cast<int>(io_Cluster.MinPos.y), io_Cluster.Length, io_Cluster.Width);
 
-	ConnectLevelNodes();
+	for(unsigned i = 0; i < io_Cluster.Entrances.size(); ++i)
+	{
+		if(!io_Search.Run(CellInCluster(io_Cluster, BaseNode(io_Cluster.Entrances[i]))))
+			continue;
 
-	// Setting the iterators to make the Navigator resumable
-	m_CurrentCluster = m_Clusters[1].begin();
-	m_CurrentFirstNode = m_CurrentCluster->BaseNodes.begin();
-	m_CurrentSecondNode = m_CurrentCluster->BaseNodes.begin() + 1;
-	m_NodesEnd = m_CurrentCluster->BaseNodes.end();
+		++io_Statistics.Searches;
+		io_Statistics.Expansions += io_Search.Expansions();
+		for(unsigned l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
+		{
+			if(io_Search.Reached(l_Cell))
+				l_Distances[i * l_NbCells + l_Cell] = io_Search.Cost(l_Cell);
+		}
+	}
 }
 
-void Navigator::ConnectLevelNodes()
+// Every search from a cell of the cluster gives its paths to all the other cells
+template<class SearchType>
+void Navigator::BuildClusterPaths(const Cluster & in_Cluster, SearchType & io_Search, ClusterPaths & out_Paths, SearchStatistics & io_Statistics) const
 {
-	for(m_CurrentCluster = m_Clusters[1].begin(); m_CurrentCluster != m_Clusters[1].end(); ++m_CurrentCluster)
+	const unsigned l_NbCells = in_Cluster.Length * in_Cluster.Width;
+	io_Search.Load(m_Grid, static_cast<int>(in_Cluster.MinPos.x), static_cast<int>(in_Cluster.MinPos.y), in_Cluster.Length, in_Cluster.Width);
+
+	for(unsigned l_Source = 0; l_Source < l_NbCells; ++l_Source)
 	{
-		for(unsigned i = 0; i < m_CurrentCluster->LevelNodes.size()-1; ++i)
+		boost::this_thread::interruption_point();
+		if(!io_Search.Run(l_Source))
+			continue;
+
+		++io_Statistics.Searches;
+		io_Statistics.Expansions += io_Search.Expansions();
+		for(unsigned l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
 		{
-			m_CurrentFirstNode = FindCorrespondingBaseNode(*m_CurrentCluster, m_CurrentCluster->LevelNodes[i]);
-			for(unsigned j = i + 1; j < m_CurrentCluster->LevelNodes.size(); ++j)
-			{
-				m_CurrentSecondNode = FindCorrespondingBaseNode(*m_CurrentCluster, m_CurrentCluster->LevelNodes[j]);
-				m_NodesEnd = m_CurrentCluster->LevelNodes.end();
-		
-				double l_Distance = AStar(*m_CurrentFirstNode, *m_CurrentSecondNode, m_CurrentCluster->LocalGraph, TrivialHeuristic());
+			if(l_Cell != l_Source && io_Search.Reached(l_Cell))
+				out_Paths.SetParent(l_Source, l_Cell, io_Search.Parent(l_Cell));
+		}
+	}
+}
+
+// The searches of the clusters run on the workers, their edges are then added in the order of the clusters. The fixed
+// searches keep their own state, the workers need no search context.
+void Navigator::ConnectLevelNodes(Graph & out_Graph)
+{
+	const unsigned l_NbWorkers = WorkersFor(static_cast<unsigned>(m_Clusters[1].size()));
+	ForEachClusterOnWorkers(m_Clusters[1], l_NbWorkers, [this](Cluster & io_Cluster, const unsigned, SearchStatistics & io_Statistics)
+	{
+		BuildEntranceDistances(io_Cluster, io_Statistics);
+	});
 
+	for(auto l_ClusterIt = m_Clusters[1].begin(); l_ClusterIt != m_Clusters[1].end(); ++l_ClusterIt)
+	{
+		const NodeVector & l_Entrances = l_ClusterIt->Entrances;
+		const unsigned l_NbCells = l_ClusterIt->Length * l_ClusterIt->Width;
+		for(unsigned i = 0; i + 1 < l_Entrances.size(); ++i)
+		{
+			for(unsigned j = i + 1; j < l_Entrances.size(); ++j)
+			{
+				const double l_Distance = l_ClusterIt->EntranceDistances[i * l_NbCells + CellInCluster(*l_ClusterIt, l_Entrances[j])];
 				if(l_Distance < std::numeric_limits<double>::infinity())
 				{
-					m_Graphs[1][m_CurrentCluster->LevelNodes[i]][m_CurrentCluster->LevelNodes[j]] = l_Distance;
-					m_Graphs[1][m_CurrentCluster->LevelNodes[j]][m_CurrentCluster->LevelNodes[i]] = l_Distance;
+					out_Graph[l_Entrances[i]][l_Entrances[j]] = l_Distance;
+					out_Graph[l_Entrances[j]][l_Entrances[i]] = l_Distance;
 				}
 			}
 		}		
 	}
 }
 
-Navigator::NodeIterator Navigator::FindCorrespondingBaseNode(Cluster & in_Cluster, const std::shared_ptr<Navigator::Node> & in_LevelNode) const
+// Runs on the background worker. The clusters past the memory budget are left to the concrete queries.
+void Navigator::ProcessClusters()
 {
-	return std::find_if(in_Cluster.BaseNodes.begin(), in_Cluster.BaseNodes.end(), 
-				[&in_Cluster, &in_LevelNode](const std::shared_ptr<Node> & in_Node)
-			{
-				return in_Node->Position == in_LevelNode->Position;
-			});
+	SearchStatistics l_Statistics;
+	std::size_t l_Bytes = 0;
+	for(unsigned i = 0; i < m_Clusters[1].size(); ++i)
+	{
+		const Cluster & l_Cluster = m_Clusters[1][i];
+		l_Bytes += ClusterPaths::Bytes(l_Cluster.Length, l_Cluster.Width);
+		if(l_Bytes > M_CLUSTERPATHSBUDGET)
+			return;
+
+		boost::shared_ptr<ClusterPaths> l_Paths(new ClusterPaths(static_cast<int>(l_Cluster.MinPos.x), static_cast<int>(l_Cluster.MinPos.y), 
+			l_Cluster.Length, l_Cluster.Width));
+		ClusterPathsTask l_Task(*this, l_Cluster, *l_Paths, l_Statistics);
+		WithFixedSearch(l_Cluster, l_Task);
+
+		boost::atomic_store(&m_ClusterPaths[i], ClusterPathsPtr(l_Paths));
+	}
 }
 
-Navigator::NodeIterator Navigator::FindCorrespondingBaseNode(Cluster & in_Cluster, const Navigator::Node & in_LevelNode) const
+void Navigator::Preprocess()
 {
-	return std::find_if(in_Cluster.BaseNodes.begin(), in_Cluster.BaseNodes.end(), 
-				[&in_Cluster, &in_LevelNode](const std::shared_ptr<Node> & in_Node)
-			{
-				return in_Node->Position == in_LevelNode.Position;
-			});
+	AbstractMaze();
+	BuildGraph();
+
+	for(int l_Level = 2; NeedsUpperLevel(); ++l_Level)
+	{
+		BuildUpperClusters(l_Level);
+		BuildUpperEntrances(l_Level);
+		BuildUpperGraph(l_Level);
+	}
+
+	BuildDistanceTable();
+	BuildLandmarks();
+	m_ClusterPaths.assign(m_Clusters[1].size(), ClusterPathsPtr());
 }
 
-void Navigator::AddIntraEdges(const double in_Time)
+// Planar selection: the map is cut in as many angular sectors around its center as there are landmarks, and the landmark
+// of a sector is its walkable cell the farthest from the center. The landmarks do not depend on each other so the workers
+// share their searches. The cells a landmark cannot reach get no bound from it.
+void Navigator::BuildLandmarks()
 {
-	boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+	const unsigned l_NbCells = m_LevelLength * m_LevelWidth;
+	const unsigned l_NbLandmarks = static_cast<unsigned>(std::min<std::size_t>(m_NbLandmarks, M_LANDMARKSBUDGET / (l_NbCells * sizeof(float))));
+	const double l_CenterX = (m_LevelWidth - 1) / 2.0, l_CenterY = (m_LevelLength - 1) / 2.0;
+	const double l_Pi = 3.14159265358979323846;
+	if(!l_NbLandmarks)
+	{
+		m_Landmarks.Clear();
+		return;
+	}
 
-	ResumableEmbeddedLoop(m_CurrentFirstNode, m_CurrentSecondNode, m_NodesEnd, 
-		[this]()
+	NodeVector l_Landmarks(l_NbLandmarks, NodeId(M_NONODE));
+	std::vector<double> l_Farthest(l_NbLandmarks, -1.0);
+	for(NodeId l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
+	{
+		if(m_Nodes.Heights[l_Cell])
+			continue;
+
+		const double l_DX = m_Nodes.X[l_Cell] - l_CenterX, l_DY = m_Nodes.Y[l_Cell] - l_CenterY;
+		const unsigned l_Sector = std::min(static_cast<unsigned>((atan2(l_DY, l_DX) + l_Pi) / (2.0 * l_Pi) * l_NbLandmarks), l_NbLandmarks - 1);
+		if(l_DX * l_DX + l_DY * l_DY > l_Farthest[l_Sector])
 		{
-			double l_Distance = AStar(*m_CurrentFirstNode, *m_CurrentSecondNode, m_CurrentCluster->LocalGraph, TrivialHeuristic());
+			l_Farthest[l_Sector] = l_DX * l_DX + l_DY * l_DY;
+			l_Landmarks[l_Sector] = l_Cell;
+		}
+	}
+	// Sectors without a walkable cell get no landmark
+	l_Landmarks.erase(std::remove(l_Landmarks.begin(), l_Landmarks.end(), NodeId(M_NONODE)), l_Landmarks.end());
 
-			if(l_Distance < std::numeric_limits<double>::infinity())
-			{
-				m_CurrentCluster->LocalGraph[*m_CurrentFirstNode][*m_CurrentSecondNode] = l_Distance;
-			}
-		}, 
-		[&l_Start, &in_Time]()
-		{ return in_Time - (boost::chrono::high_resolution_clock::now() - l_Start).count() > 0.0; });
+	m_Landmarks.Reset(m_LevelWidth, l_NbCells, static_cast<unsigned>(l_Landmarks.size()));
+	for(unsigned i = 0; i < l_Landmarks.size(); ++i)
+		m_Landmarks.SetCell(i, l_Landmarks[i]);
+
+	const unsigned l_NbWorkers = PrepareWorkers(static_cast<unsigned>(l_Landmarks.size()));
+	std::vector<SearchStatistics> l_Statistics(l_NbWorkers);
+	ParallelFor(static_cast<unsigned>(l_Landmarks.size()), l_NbWorkers, [&l_Landmarks, &l_Statistics, l_NbCells, this](const unsigned in_Index, const unsigned in_Worker)
+	{
+		SearchContext & l_Context = in_Worker ? m_WorkerContexts[in_Worker - 1] : m_SearchContext;
+		Dijkstra(l_Landmarks[in_Index], m_Grid.Whole(), l_Context, l_Statistics[in_Worker]);
+		for(NodeId l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
+		{
+			if(l_Context.Closed(l_Cell))
+				m_Landmarks.SetDistance(in_Index, l_Cell, l_Context.Cost(l_Cell));
+		}
+	});
+
+	for(auto l_It = l_Statistics.begin(); l_It != l_Statistics.end(); ++l_It)
+	{
+		m_Statistics.Searches += l_It->Searches;
+		m_Statistics.Expansions += l_It->Expansions;
+	}
 }
 
-void Navigator::Preprocess()
+// One search from each goal over the whole grid, the grid is undirected so the parent of a cell in the search tree of
+// a goal is its next cell toward it. The fields depend only on the grid, they are not part of the cache.
+void Navigator::BuildFlowFields()
 {
-	AbstractMaze();
-	BuildGraph();
+	m_FlowFields.clear();
+	m_FlowFields.reserve(m_FlowGoals.size());
+	for(auto l_It = m_FlowGoals.begin(); l_It != m_FlowGoals.end(); ++l_It)
+		m_FlowFields.push_back(FlowField(BaseNode(LevelCell(*l_It)), m_LevelLength, m_LevelWidth));
+
+	const unsigned l_NbCells = m_LevelLength * m_LevelWidth;
+	const unsigned l_NbWorkers = PrepareWorkers(static_cast<unsigned>(m_FlowFields.size()));
+	std::vector<SearchStatistics> l_Statistics(l_NbWorkers);
+	ParallelFor(static_cast<unsigned>(m_FlowFields.size()), l_NbWorkers, [&l_Statistics, l_NbCells, this](const unsigned in_Index, const unsigned in_Worker)
+	{
+		SearchContext & l_Context = in_Worker ? m_WorkerContexts[in_Worker - 1] : m_SearchContext;
+		FlowField & l_Field = m_FlowFields[in_Index];
+		if(!m_Grid.Walkable(l_Field.Goal() % m_LevelWidth, l_Field.Goal() / m_LevelWidth))
+			return;
+
+		Dijkstra(l_Field.Goal(), m_Grid.Whole(), l_Context, l_Statistics[in_Worker]);
+		l_Field.SetGoalReached();
+		for(NodeId l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
+		{
+			if(l_Cell != l_Field.Goal() && l_Context.Closed(l_Cell))
+				l_Field.SetStep(l_Cell, l_Context.Parent(l_Cell), l_Context.Cost(l_Cell));
+		}
+	});
+
+	for(auto l_It = l_Statistics.begin(); l_It != l_Statistics.end(); ++l_It)
+	{
+		m_Statistics.Searches += l_It->Searches;
+		m_Statistics.Expansions += l_It->Expansions;
+	}
+}
+
+void Navigator::IndexEntrances()
+{
+	m_TableOffsets.assign(1, 0);
+	for(auto l_It = m_Clusters[1].begin(); l_It != m_Clusters[1].end(); ++l_It)
+		m_TableOffsets.push_back(m_TableOffsets.back() + static_cast<unsigned>(l_It->Entrances.size()));
+}
+
+// One search per entrance on the first abstract level, the rows are independent so the workers share them
+void Navigator::BuildDistanceTable()
+{
+	IndexEntrances();
+	const unsigned l_NbEntrances = m_TableOffsets.back();
+	m_DistanceTable.clear();
+	if(static_cast<std::size_t>(l_NbEntrances) * l_NbEntrances * sizeof(float) > M_DISTANCETABLEBUDGET)
+		return;
+
+	NodeVector l_Entrances;
+	l_Entrances.reserve(l_NbEntrances);
+	for(auto l_It = m_Clusters[1].begin(); l_It != m_Clusters[1].end(); ++l_It)
+		l_Entrances.insert(l_Entrances.end(), l_It->Entrances.begin(), l_It->Entrances.end());
+
+	std::vector<float> & l_Table = m_DistanceTable.Owned();
+	l_Table.resize(static_cast<std::size_t>(l_NbEntrances) * l_NbEntrances);
+	const unsigned l_NbWorkers = PrepareWorkers(l_NbEntrances);
+	std::vector<SearchStatistics> l_Statistics(l_NbWorkers);
+	ParallelFor(l_NbEntrances, l_NbWorkers, [&l_Entrances, &l_Statistics, &l_Table, l_NbEntrances, this](const unsigned in_Index, const unsigned in_Worker)
+	{
+		SearchContext & l_Context = in_Worker ? m_WorkerContexts[in_Worker - 1] : m_SearchContext;
+		Dijkstra(l_Entrances[in_Index], m_Graphs[1], l_Context, l_Statistics[in_Worker]);
+		float * l_Row = &l_Table[static_cast<std::size_t>(in_Index) * l_NbEntrances];
+		for(unsigned i = 0; i < l_NbEntrances; ++i)
+			l_Row[i] = static_cast<float>(l_Context.Cost(l_Entrances[i]));
+	});
+
+	for(auto l_It = l_Statistics.begin(); l_It != l_Statistics.end(); ++l_It)
+	{
+		m_Statistics.Searches += l_It->Searches;
+		m_Statistics.Expansions += l_It->Expansions;
+	}
+}
+
+void Navigator::StartClusterProcessing()
+{
+	StopClusterProcessing();
+	m_Worker = boost::thread(&Navigator::ProcessClusters, this);
+}
+
+void Navigator::StopClusterProcessing()
+{
+	if(!m_Worker.joinable())
+		return;
+
+	m_Worker.interrupt();
+	m_Worker.join();
+}
+
+void Navigator::WaitClusterProcessing()
+{
+	if(m_Worker.joinable())
+		m_Worker.join();
+}
+
+unsigned Navigator::GetNbProcessedClusters() const
+{
+	unsigned l_NbProcessed = 0;
+	for(auto l_It = m_ClusterPaths.begin(); l_It != m_ClusterPaths.end(); ++l_It)
+	{
+		if(boost::atomic_load(&*l_It))
+			++l_NbProcessed;
+	}
+	return l_NbProcessed;
 }
 
 // ********** Online processing **********
 
-void Navigator::ConnectToBorder(const std::shared_ptr<Node> & in_Node, Cluster & in_Cluster)
+// Links a query node to the entrances of its cluster on an upper level with a search on the level below.
+// The other query node is linked too when it is in the same cluster.
+void Navigator::ConnectToUpperBorder(const NodeId in_Node, const NodeId in_Other, const Cluster & in_Cluster)
 {
-	for(auto l_It = in_Cluster.LevelNodes.begin(); l_It != in_Cluster.LevelNodes.end(); ++l_It)
+	if(!Dijkstra(in_Node, ClusterGraph(m_Graphs[in_Cluster.Level - 1], in_Cluster)))
+		return;
+
+	CompactGraph & l_Graph = m_Graphs[in_Cluster.Level];
+	for(auto l_It = in_Cluster.Entrances.begin(); l_It != in_Cluster.Entrances.end(); ++l_It)
 	{
-		double l_Distance = AStar(*FindCorrespondingBaseNode(in_Cluster, in_Node), *FindCorrespondingBaseNode(in_Cluster, *l_It), 
-			in_Cluster.LocalGraph, TrivialHeuristic());
+		if(*l_It != in_Node && m_SearchContext.Closed(*l_It))
+		{
+			l_Graph.AddOverlayEdge(in_Node, *l_It, m_SearchContext.Cost(*l_It));
+			l_Graph.AddOverlayEdge(*l_It, in_Node, m_SearchContext.Cost(*l_It));
+		}
+	}
 
-		if(l_Distance < std::numeric_limits<double>::infinity())
+	if(in_Other != M_NONODE && in_Other != in_Node && Contains(in_Cluster, in_Other) && m_SearchContext.Closed(in_Other))
+	{
+		l_Graph.AddOverlayEdge(in_Node, in_Other, m_SearchContext.Cost(in_Other));
+		l_Graph.AddOverlayEdge(in_Other, in_Node, m_SearchContext.Cost(in_Other));
+	}
+}
+
+// Replaces the edges of a path found on an upper level that stay inside one of its clusters by their path on the level below
+void Navigator::RefinePath(const int in_Level, const NodeVector & in_Path, NodeVector & out_Path)
+{
+	out_Path.clear();
+	out_Path.push_back(in_Path.front());
+	for(auto l_It = in_Path.begin() + 1; l_It != in_Path.end(); ++l_It)
+	{
+		const NodeId l_From = *(l_It - 1);
+		const NodeId l_To = *l_It;
+		const unsigned l_ClusterIndex = ClusterIndex(m_Nodes.Position(l_From), in_Level);
+		if(l_ClusterIndex != ClusterIndex(m_Nodes.Position(l_To), in_Level))
+		{
+			// Gates are on every level
+			out_Path.push_back(l_To);
+			continue;
+		}
+
+		// Paths between entrances were kept during the preprocessing, only the ones of the query are searched
+		const Cluster & l_Cluster = m_Clusters[in_Level][l_ClusterIndex];
+		auto l_FromIt = std::lower_bound(l_Cluster.Entrances.begin(), l_Cluster.Entrances.end(), l_From);
+		auto l_ToIt = std::lower_bound(l_Cluster.Entrances.begin(), l_Cluster.Entrances.end(), l_To);
+		if(l_FromIt != l_Cluster.Entrances.end() && *l_FromIt == l_From && l_ToIt != l_Cluster.Entrances.end() && *l_ToIt == l_To)
+		{
+			const unsigned l_NbEntrances = static_cast<unsigned>(l_Cluster.Entrances.size());
+			const unsigned l_FromIndex = static_cast<unsigned>(l_FromIt - l_Cluster.Entrances.begin());
+			const unsigned l_ToIndex = static_cast<unsigned>(l_ToIt - l_Cluster.Entrances.begin());
+			if(l_FromIndex < l_ToIndex)
+			{
+				const NodeVector & l_Path = l_Cluster.EntrancePaths[l_FromIndex * l_NbEntrances + l_ToIndex];
+				out_Path.insert(out_Path.end(), l_Path.begin() + 1, l_Path.end());
+			}
+			else
+			{
+				const NodeVector & l_Path = l_Cluster.EntrancePaths[l_ToIndex * l_NbEntrances + l_FromIndex];
+				out_Path.insert(out_Path.end(), l_Path.rbegin() + 1, l_Path.rend());
+			}
+		}
+		else if(AStar(l_From, l_To, ClusterGraph(m_Graphs[in_Level - 1], l_Cluster), MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Landmarks))) < std::numeric_limits<double>::infinity())
+		{
+			ExtractPath(l_To, m_SegmentBuffer);
+			out_Path.insert(out_Path.end(), m_SegmentBuffer.begin() + 1, m_SegmentBuffer.end());
+		}
+		else
+		{
+			out_Path.push_back(l_To);
+		}
+	}
+}
+
+// The distances to the entrances were computed during the preprocessing so this is only a lookup
+void Navigator::ConnectToBorder(const NodeId in_Node, Cluster & in_Cluster)
+{
+	const unsigned l_NbCells = in_Cluster.Length * in_Cluster.Width;
+	const unsigned l_Cell = CellInCluster(in_Cluster, in_Node);
+
+	for(unsigned i = 0; i < in_Cluster.Entrances.size(); ++i)
+	{
+		const double l_Distance = in_Cluster.EntranceDistances[i * l_NbCells + l_Cell];
+		if(in_Cluster.Entrances[i] != in_Node && l_Distance < std::numeric_limits<double>::infinity())
 		{
-			m_Graphs[in_Cluster.Level][in_Node][*l_It] = l_Distance;
-			m_Graphs[in_Cluster.Level][*l_It][in_Node] = l_Distance;
+			m_Graphs[in_Cluster.Level].AddOverlayEdge(in_Node, in_Cluster.Entrances[i], l_Distance);
+			m_Graphs[in_Cluster.Level].AddOverlayEdge(in_Cluster.Entrances[i], in_Node, l_Distance);
 		}
 	}
 }
@@ -559,114 +1624,228 @@ void Navigator::ConnectToBorder(const std::shared_ptr<Node> & in_Node, Cluster &
 Navigator::NodeVector Navigator::ComputeAbstractPath(const Vector2 & in_Start, const Vector2 & in_Goal)
 {
 	if(in_Start == in_Goal)
-		return std::vector<std::shared_ptr<Node>>();
-
-	std::shared_ptr<Node> l_StartNode;
-	std::shared_ptr<Node> l_EndNode;
-	auto l_CIt = m_Clusters[0].begin();
+		return NodeVector();
 
-	Vector2 l_StartPos(in_Start.x >= l_CIt->Width ? l_CIt->Width : floor(in_Start.x + 0.5f), 
-		in_Start.y >= l_CIt->Length ? l_CIt->Length : floor(in_Start.y + 0.5f));
-	Vector2 l_GoalPos(in_Goal.x >= l_CIt->Width ? l_CIt->Width : floor(in_Goal.x + 0.5f), 
-		in_Goal.y >= l_CIt->Length ? l_CIt->Length : floor(in_Goal.y + 0.5f));
+	const Vector2 l_StartPos(LevelCell(in_Start));
+	const Vector2 l_GoalPos(LevelCell(in_Goal));
+	if(!SameComponent(m_Components, BaseNode(l_StartPos), BaseNode(l_GoalPos)))
+		return NodeVector();
 
-	auto l_GoalIt = m_Clusters[1].begin();
-	for(; l_GoalIt != m_Clusters[1].end(); ++l_GoalIt)
+	// The jump points are on straight or diagonal lines so the concrete paths between them are cheap
+	if(!IsHierarchyReady())
 	{
-		if(l_GoalIt->MinPos <= l_GoalPos && l_GoalPos <= l_GoalIt->MaxPos)
-			break;
+		if(SearchFlat(BaseNode(l_StartPos), BaseNode(l_GoalPos)) == std::numeric_limits<double>::infinity())
+			return NodeVector();
+		ExtractPath(BaseNode(l_GoalPos), m_FlatContext, m_PathBuffer);
+		return m_PathBuffer;
 	}
-	
-	if(l_GoalIt == m_Clusters[1].end())
-		return std::vector<std::shared_ptr<Node>>();
-	
-	for(auto l_NodesIt = l_GoalIt->LevelNodes.begin(); l_NodesIt != l_GoalIt->LevelNodes.end(); ++l_NodesIt)
+
+	// The start and the goal are not added to the abstract graph. They are represented by their entrance
+	// if they are on one, by their base node otherwise, and they only live in the overlay during the search.
+	const NodeId l_StartNode = QueryNode(l_StartPos);
+	const NodeId l_EndNode = QueryNode(l_GoalPos);
+
+	bool l_Reversed = false;
+	const NodeVector * l_CachedPath = m_AbstractPaths.Find(l_StartNode, l_EndNode, l_Reversed);
+	if(l_CachedPath)
+		return l_Reversed ? NodeVector(l_CachedPath->rbegin(), l_CachedPath->rend()) : *l_CachedPath;
+
+	// Every level gets the edges of the query, the search runs on the top one and its path is refined down to the first level
+	Cluster & l_StartCluster = ClusterAt(l_StartPos);
+	Cluster & l_GoalCluster = ClusterAt(l_GoalPos);
+	ConnectToBorder(l_StartNode, l_StartCluster);
+	ConnectToBorder(l_EndNode, l_GoalCluster);
+
+	// The entrances are not always on the shortest path between two cells of the same cluster
+	if(&l_StartCluster == &l_GoalCluster)
 	{
-		if((*l_NodesIt)->Height == 0 && (*l_NodesIt)->Level == 1 && (*l_NodesIt)->Position == l_GoalPos)
+		double l_Distance = SearchCluster(BaseNode(l_StartPos), BaseNode(l_GoalPos), l_StartCluster);
+		if(l_Distance < std::numeric_limits<double>::infinity())
 		{
-			l_EndNode = *l_NodesIt;
-			break;
+			m_Graphs[1].AddOverlayEdge(l_StartNode, l_EndNode, l_Distance);
+			m_Graphs[1].AddOverlayEdge(l_EndNode, l_StartNode, l_Distance);
 		}
 	}
-
-	auto l_StartIt = m_Clusters[1].begin();
-	for(; l_StartIt != m_Clusters[1].end(); ++l_StartIt)
+	
+	const int l_Top = GetDepth();
+	for(int l_Level = 2; l_Level <= l_Top; ++l_Level)
 	{
-		if(l_StartIt->MinPos <= l_StartPos && l_StartPos <= l_StartIt->MaxPos)
-			break;
+		ConnectToUpperBorder(l_StartNode, l_EndNode, ClusterAt(l_StartPos, l_Level));
+		ConnectToUpperBorder(l_EndNode, M_NONODE, ClusterAt(l_GoalPos, l_Level));
 	}
 	
-	if(l_StartIt == m_Clusters[1].end())
-		return std::vector<std::shared_ptr<Node>>();
-	
-	for(auto l_NodesIt = l_StartIt->LevelNodes.begin(); l_NodesIt != l_StartIt->LevelNodes.end(); ++l_NodesIt)
+	double l_Cost = std::numeric_limits<double>::infinity();
+	if(m_AbstractSearch == BidirectionalSearch)
 	{
-		if((*l_NodesIt)->Height == 0 && (*l_NodesIt)->Level == 1 && (*l_NodesIt)->Position == l_StartPos)
-		{
-			l_StartNode = *l_NodesIt;
-			break;
-		}
+		std::pair<NodeId, NodeId> l_Meeting;
+		l_Cost = BidirectionalAStar(l_StartNode, l_EndNode, m_Graphs[l_Top], MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Landmarks)), l_Meeting);
+		if(l_Cost < std::numeric_limits<double>::infinity())
+			ExtractBidirectionalPath(l_Meeting, m_PathBuffer);
+	}
+	else
+	{
+		l_Cost = AStar(l_StartNode, l_EndNode, m_Graphs[l_Top], MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Landmarks)));
+		if(l_Cost < std::numeric_limits<double>::infinity())
+			ExtractPath(l_EndNode, m_PathBuffer);
 	}
 
-	if(!l_StartNode)
+	if(l_Cost < std::numeric_limits<double>::infinity())
 	{
-		l_StartNode = std::make_shared<Node>(Node(1, 0, l_StartPos));
-		l_StartIt->LevelNodes.push_back(l_StartNode);
+		for(int l_Level = l_Top; l_Level > 1; --l_Level)
+		{
+			RefinePath(l_Level, m_PathBuffer, m_RefinedPath);
+			m_PathBuffer.swap(m_RefinedPath);
+		}
 	}
 
-	if(!l_EndNode)
+	for(auto l_It = m_Graphs.begin(); l_It != m_Graphs.end(); ++l_It)
+		l_It->ClearOverlay();
+	if(l_Cost == std::numeric_limits<double>::infinity())
+		return NodeVector();
+
+	m_AbstractPaths.Store(l_StartNode, l_EndNode, m_PathBuffer);
+	return m_PathBuffer;
+}
+
+double Navigator::GetDistance(const Vector2 & in_Start, const Vector2 & in_Goal)
+{
+	const Vector2 l_StartPos(LevelCell(in_Start));
+	const Vector2 l_GoalPos(LevelCell(in_Goal));
+	const NodeId l_Start = BaseNode(l_StartPos);
+	const NodeId l_Goal = BaseNode(l_GoalPos);
+	if(!SameComponent(m_Components, l_Start, l_Goal))
+		return std::numeric_limits<double>::infinity();
+	if(l_Start == l_Goal)
+		return 0.0;
+	if(!IsHierarchyReady() || m_DistanceTable.empty())
+		return SearchFlat(l_Start, l_Goal);
+
+	const unsigned l_StartIndex = ClusterIndex(l_StartPos, 1);
+	const unsigned l_GoalIndex = ClusterIndex(l_GoalPos, 1);
+	const Cluster & l_StartCluster = m_Clusters[1][l_StartIndex];
+	const Cluster & l_GoalCluster = m_Clusters[1][l_GoalIndex];
+
+	// The entrances are not always on the shortest path between two cells of the same cluster
+	double l_Distance = std::numeric_limits<double>::infinity();
+	if(l_StartIndex == l_GoalIndex && SameComponent(m_ClusterComponents, l_Start, l_Goal))
+		l_Distance = AStar(l_Start, l_Goal, ClusterWindow(l_StartCluster), MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Landmarks)));
+
+	const unsigned l_NbEntrances = m_TableOffsets.back();
+	const unsigned l_StartCells = l_StartCluster.Length * l_StartCluster.Width;
+	const unsigned l_GoalCells = l_GoalCluster.Length * l_GoalCluster.Width;
+	const unsigned l_StartCell = CellInCluster(l_StartCluster, l_Start);
+	const unsigned l_GoalCell = CellInCluster(l_GoalCluster, l_Goal);
+	for(unsigned i = 0; i < l_StartCluster.Entrances.size(); ++i)
 	{
-		l_EndNode = std::make_shared<Node>(Node(1, 0, l_GoalPos));
-		l_GoalIt->LevelNodes.push_back(l_EndNode);
+		const double l_ToEntrance = l_StartCluster.EntranceDistances[i * l_StartCells + l_StartCell];
+		if(l_ToEntrance >= l_Distance || l_GoalCluster.Entrances.empty())
+			continue;
+
+		const float * l_Row = &m_DistanceTable[static_cast<std::size_t>(m_TableOffsets[l_StartIndex] + i) * l_NbEntrances + m_TableOffsets[l_GoalIndex]];
+		for(unsigned j = 0; j < l_GoalCluster.Entrances.size(); ++j)
+			l_Distance = std::min(l_Distance, l_ToEntrance + l_Row[j] + l_GoalCluster.EntranceDistances[j * l_GoalCells + l_GoalCell]);
 	}
+	return l_Distance;
+}
 
-	if(m_Paths[l_StartNode][l_EndNode] != NodeVector())
-		return NodeVector(m_Paths[l_StartNode][l_EndNode].begin(), m_Paths[l_StartNode][l_EndNode].end());
+// Base nodes were created first so their index is also their cell index
+Navigator::NodeId Navigator::BaseNode(const Vector2 & in_Position) const
+{
+	return static_cast<int>(in_Position.x) + static_cast<int>(in_Position.y) * m_LevelWidth;
+}
 
-	ConnectToBorder(l_StartNode, *l_StartIt);
-	ConnectToBorder(l_EndNode, *l_GoalIt);
-	
-	AStar(l_StartNode, l_EndNode, m_Graphs[1], ManhattanDistance());
+// Base node of the cell a node of any level is on
+Navigator::NodeId Navigator::BaseNode(const NodeId in_Node) const
+{
+	return m_Nodes.X[in_Node] + m_Nodes.Y[in_Node] * m_LevelWidth;
+}
 
-	return NodeVector(m_Paths[l_StartNode][l_EndNode].begin(), m_Paths[l_StartNode][l_EndNode].end());
+Navigator::NodeId Navigator::QueryNode(const Vector2 & in_Position) const
+{
+	const NodeId l_Entrance = m_AbstractNodes[BaseNode(in_Position)];
+	return l_Entrance != M_NONODE ? l_Entrance : BaseNode(in_Position);
 }
 
-std::vector<Vector2> Navigator::ComputeConcretePath(const std::shared_ptr<Node> & in_StartNode, const std::shared_ptr<Node> & in_GoalNode)
+// Cell closest to a position, positions outside of the level go to the nearest cell on its edge
+Vector2 Navigator::LevelCell(const Vector2 & in_Position) const
 {
-	if(!in_StartNode || !in_GoalNode)
-		return std::vector<Vector2>();
+	return Vector2(std::min<float>(std::max<float>(floor(in_Position.x + 0.5f), 0.f), static_cast<float>(m_LevelWidth - 1)),
+		std::min<float>(std::max<float>(floor(in_Position.y + 0.5f), 0.f), static_cast<float>(m_LevelLength - 1)));
+}
 
-	// Find the cluster which they belong to
-	auto l_ClusterIt = m_Clusters[1].begin();
-	for(; l_ClusterIt != m_Clusters[1].end(); ++l_ClusterIt)
-		if(l_ClusterIt->MinPos <= in_StartNode->Position && in_StartNode->Position <= l_ClusterIt->MaxPos
-			&& l_ClusterIt->MinPos <= in_GoalNode->Position && in_GoalNode->Position <= l_ClusterIt->MaxPos)
-			break;
+unsigned Navigator::ClusterIndex(const Vector2 & in_Cell, const int in_Level) const
+{
+	const Tiling & l_Tiling = m_Tilings[in_Level];
+	return static_cast<int>(in_Cell.x) / l_Tiling.ClusterWidth + (static_cast<int>(in_Cell.y) / l_Tiling.ClusterLength) * l_Tiling.NbColumns;
+}
 
-	if(l_ClusterIt == m_Clusters[1].end())
-		return std::vector<Vector2>();
+Navigator::Cluster & Navigator::ClusterAt(const Vector2 & in_Cell, const int in_Level)
+{
+	return m_Clusters[in_Level][ClusterIndex(in_Cell, in_Level)];
+}
 
-	std::shared_ptr<Navigator::Node> l_BaseStart(*FindCorrespondingBaseNode(*l_ClusterIt, in_StartNode));
-	std::shared_ptr<Navigator::Node> l_BaseGoal(*FindCorrespondingBaseNode(*l_ClusterIt, in_GoalNode));
-	
-	if(m_Paths[l_BaseStart][l_BaseGoal] == NodeVector())
-		AStar(l_BaseStart, l_BaseGoal, l_ClusterIt->LocalGraph, TrivialHeuristic());
+bool Navigator::Contains(const Cluster & in_Cluster, const NodeId in_Node) const
+{
+	return m_Nodes.X[in_Node] >= in_Cluster.MinPos.x && m_Nodes.X[in_Node] <= in_Cluster.MaxPos.x
+		&& m_Nodes.Y[in_Node] >= in_Cluster.MinPos.y && m_Nodes.Y[in_Node] <= in_Cluster.MaxPos.y;
+}
 
+std::vector<Vector2> Navigator::ComputeConcretePath(const NodeId in_StartNode, const NodeId in_GoalNode)
+{
 	std::vector<Vector2> l_ConcretePath;
-	std::transform(m_Paths[l_BaseStart][l_BaseGoal].begin(), m_Paths[l_BaseStart][l_BaseGoal].end(), std::back_inserter(l_ConcretePath),
-		[](const std::shared_ptr<Node> & in_Node)
-		{
-			return in_Node->Position;
-		});
-
+	ComputeConcretePath(in_StartNode, in_GoalNode, l_ConcretePath);
 	return l_ConcretePath;
 }
 
-void Navigator::ProcessClusters(const double in_Time)
+void Navigator::ComputeConcretePath(const NodeId in_StartNode, const NodeId in_GoalNode, std::vector<Vector2> & out_Path)
 {
-	boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+	// Only the base nodes exist for the queries until the hierarchy is ready
+	const bool l_HierarchyReady = IsHierarchyReady();
+	const unsigned l_NbNodes = l_HierarchyReady ? m_Nodes.Size() : m_LevelLength * m_LevelWidth;
+	out_Path.clear();
+	if(in_StartNode >= l_NbNodes || in_GoalNode >= l_NbNodes)
+		return;
+
+	const NodeId l_BaseStart = BaseNode(in_StartNode);
+	const NodeId l_BaseGoal = BaseNode(in_GoalNode);
+
+	// Nodes in different clusters are either the two sides of a gate, with nothing to search between them,
+	// or come from a path found before the hierarchy was ready
+	if(!l_HierarchyReady || &ClusterAt(m_Nodes.Position(in_StartNode)) != &ClusterAt(m_Nodes.Position(in_GoalNode)))
+	{
+		if(std::abs(m_Nodes.X[l_BaseStart] - m_Nodes.X[l_BaseGoal]) + std::abs(m_Nodes.Y[l_BaseStart] - m_Nodes.Y[l_BaseGoal]) == 1
+			|| SearchFlat(l_BaseStart, l_BaseGoal) == std::numeric_limits<double>::infinity())
+			return;
+		ExtractJumpPath(l_BaseGoal, m_FlatContext, m_PathBuffer);
+	}
+	else
+	{
+		Cluster & l_Cluster = ClusterAt(m_Nodes.Position(in_StartNode));
 
-	ResumableForEach(m_CurrentCluster, m_Clusters[1].end(), 
-		[&in_Time, this]() { AddIntraEdges(in_Time); }, 
-		[&in_Time, &l_Start]() { return in_Time - (boost::chrono::high_resolution_clock::now() - l_Start).count() > 0.0; });
+		// Once published, the paths of a cluster do not change anymore
+		const ClusterPathsPtr l_ClusterPaths(boost::atomic_load(&m_ClusterPaths[ClusterIndex(m_Nodes.Position(in_StartNode), 1)]));
+		if(l_ClusterPaths)
+		{
+			l_ClusterPaths->Decode(CellInCluster(l_Cluster, l_BaseStart), CellInCluster(l_Cluster, l_BaseGoal), out_Path);
+			return;
+		}
+	
+		bool l_Reversed = false;
+		const EncodedPath * l_Path = m_ConcretePaths.Find(l_BaseStart, l_BaseGoal, l_Reversed);
+		if(l_Path)
+		{
+			l_Path->Decode(l_Reversed, out_Path);
+			return;
+		}
+
+		if(SearchCluster(l_BaseStart, l_BaseGoal, l_Cluster) == std::numeric_limits<double>::infinity())
+			return;
+		m_ConcretePaths.Store(l_BaseStart, l_BaseGoal, EncodePath(m_PathBuffer));
+	}
+
+	std::transform(m_PathBuffer.begin(), m_PathBuffer.end(), std::back_inserter(out_Path),
+		[this](const NodeId in_Node)
+		{
+			return m_Nodes.Position(in_Node);
+		});
 }
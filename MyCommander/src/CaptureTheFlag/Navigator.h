@@ -1,17 +1,31 @@
 #ifndef NAVIGATOR_H
 #define NAVIGATOR_H
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 #include <utility>
 
 #include <boost/chrono/chrono.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include "api\Vector2.h"
+#include "ClusterPaths.h"
+#include "CompactGraph.h"
+#include "EncodedPath.h"
+#include "FixedClusterSearch.h"
+#include "FlowField.h"
+#include "GridGraph.h"
+#include "Landmarks.h"
+#include "MappedArray.h"
+#include "PathCache.h"
+#include "SearchContext.h"
+#include "Wavefront.h"
 
-class IHeuristic;
 
 /*
 * Author : Felix-Antoine Ouellet
@@ -19,13 +33,23 @@ class IHeuristic;
 *
 * Navigator
 * Plan the shortest safe distance toward a goal for the bots by using the HPA* algorithm.
-* Note that it computes only one abstract layer since the levels it is applied on is relatively small.
+* The first abstract level cuts the map in clusters of cells, every level above it groups the clusters
+* of the level below. Levels are added until the top one has few enough clusters, so small maps only
+* get one abstract level.
 */
 class Navigator
 {
-	struct Cluster;
+	// Gives the tests access to the search internals
+	friend struct NavigationFixture;
 
 public:
+	// Nodes are referred to by dense 32-bit indices. Base nodes come first so that their index is also their cell index.
+	typedef std::uint32_t NodeId;
+	typedef std::vector<NodeId> NodeVector;
+
+	static const NodeId M_NONODE = 0xFFFFFFFF;
+
+	// Value view of a node, as returned by GetNode
 	struct Node
 	{
 		int Level;
@@ -35,10 +59,6 @@ public:
 		Node(const int in_Level = 0, const int in_Height = 0, const Vector2 & in_Position = Vector2(0.f, 0.f)) : 
 			Level(in_Level), Height(in_Height), Position(in_Position) { }
 
-		Node(const Node & in_Node) : Level(in_Node.Level), Height(in_Node.Height), Position(in_Node.Position) { }
-
-		Node(Node && in_Node) : Level(std::move(in_Node.Level)), Height(std::move(in_Node.Height)), Position(std::move(in_Node.Position)) { }
-
 		bool operator==(const Node & in_Node) const
 		{
 			return Level == in_Node.Level && Height == in_Node.Height && Position == in_Node.Position;
@@ -59,28 +79,57 @@ public:
 	};
 
 private:
-	struct NodeComparer
+	// Structure of arrays holding every node of every level
+	struct NodeStore
 	{
-		bool operator()(const std::shared_ptr<Node> & in_Node1, const std::shared_ptr<Node> & in_Node2)
+		std::vector<unsigned char> Levels;
+		std::vector<int> Heights;
+		std::vector<unsigned short> X;
+		std::vector<unsigned short> Y;
+
+		NodeId Add(const int in_Level, const int in_Height, const Vector2 & in_Position)
 		{
-			return *in_Node1 < *in_Node2;
+			Levels.push_back(static_cast<unsigned char>(in_Level));
+			Heights.push_back(in_Height);
+			X.push_back(static_cast<unsigned short>(in_Position.x));
+			Y.push_back(static_cast<unsigned short>(in_Position.y));
+			return static_cast<NodeId>(Levels.size() - 1);
 		}
-	};
 
-	struct PositionComparer
-	{
-		bool operator()(const std::shared_ptr<Node> & in_Node1, const std::shared_ptr<Node> & in_Node2)
+		void Reserve(const unsigned in_NbNodes)
 		{
-			return in_Node1->Position <= in_Node2->Position;
+			Levels.reserve(in_NbNodes);
+			Heights.reserve(in_NbNodes);
+			X.reserve(in_NbNodes);
+			Y.reserve(in_NbNodes);
 		}
+
+		void Clear()
+		{
+			Levels.clear();
+			Heights.clear();
+			X.clear();
+			Y.clear();
+		}
+
+		void Swap(NodeStore & io_Nodes)
+		{
+			Levels.swap(io_Nodes.Levels);
+			Heights.swap(io_Nodes.Heights);
+			X.swap(io_Nodes.X);
+			Y.swap(io_Nodes.Y);
+		}
+
+		unsigned Size() const { return static_cast<unsigned>(Levels.size()); }
+		Vector2 Position(const NodeId in_Node) const { return Vector2(X[in_Node], Y[in_Node]); }
 	};
 
 private:
-	typedef std::map<std::shared_ptr<Node>, std::map<std::shared_ptr<Node>, double, NodeComparer>, NodeComparer> Graph;
-	typedef std::pair<std::shared_ptr<Node>, std::shared_ptr<Node>> Gate;
-	typedef std::vector<std::shared_ptr<Node>>::iterator NodeIterator;
-	typedef std::vector<std::shared_ptr<Node>>::const_iterator ConstNodeIterator;
-	typedef std::vector<std::shared_ptr<Node>> NodeVector;
+	typedef std::map<NodeId, std::map<NodeId, double>> Graph;
+	typedef std::pair<NodeId, NodeId> Gate;
+	typedef NodeVector::iterator NodeIterator;
+	typedef NodeVector::const_iterator ConstNodeIterator;
+	typedef boost::shared_ptr<const ClusterPaths> ClusterPathsPtr;
 
 private:
 	enum Adjacency { Above, Below, Left, Right };
@@ -92,7 +141,13 @@ private:
 		int Width;
 		NodeVector BaseNodes;
 		NodeVector LevelNodes;
-		Graph LocalGraph;
+		// Level nodes found during preprocessing and their distance to every cell of the cluster,
+		// the distances of the i-th entrance start at i * Length * Width
+		NodeVector Entrances;
+		MappedArray<double> EntranceDistances;
+		// On the upper levels, the distance and the path on the level below between the i-th and the j-th entrance (i < j)
+		// are at i * Entrances.size() + j instead
+		std::vector<NodeVector> EntrancePaths;
 		Vector2 MinPos;
 		Vector2 MaxPos;
 
@@ -102,73 +157,364 @@ private:
 
 		Cluster(Cluster && in_Cluster) : Level(std::move(in_Cluster.Level)), Length(std::move(in_Cluster.Length)),
 			Width(std::move(in_Cluster.Width)), BaseNodes(std::move(in_Cluster.BaseNodes)), 
-			LevelNodes(std::move(in_Cluster.LevelNodes)), LocalGraph(std::move(in_Cluster.LocalGraph)) { }
+			LevelNodes(std::move(in_Cluster.LevelNodes)), Entrances(std::move(in_Cluster.Entrances)), 
+			EntranceDistances(std::move(in_Cluster.EntranceDistances)), EntrancePaths(std::move(in_Cluster.EntrancePaths)), MinPos(in_Cluster.MinPos), MaxPos(in_Cluster.MaxPos) { }
 
 		bool operator==(const Cluster & in_Cluster) const
 		{
 			return Level == in_Cluster.Level && Length == in_Cluster.Length && Width == in_Cluster.Width
-				&& BaseNodes == in_Cluster.BaseNodes && LevelNodes == in_Cluster.LevelNodes && LocalGraph == in_Cluster.LocalGraph;
+				&& BaseNodes == in_Cluster.BaseNodes && LevelNodes == in_Cluster.LevelNodes;
 		}
 	};
 
+	// Clusters of a level all have the same size, except on the right and bottom edges of the upper levels
+	struct Tiling
+	{
+		int ClusterLength;
+		int ClusterWidth;
+		int NbColumns;
+		int NbRows;
+
+		Tiling(const int in_ClusterLength, const int in_ClusterWidth, const int in_NbColumns, const int in_NbRows) :
+			ClusterLength(in_ClusterLength), ClusterWidth(in_ClusterWidth), NbColumns(in_NbColumns), NbRows(in_NbRows) { }
+	};
+
+	// Abstract graph of a level restricted to the nodes inside a cluster of the level above
+	struct ClusterGraph
+	{
+		const CompactGraph * Graph;
+		const Cluster * Area;
+
+		ClusterGraph(const CompactGraph & in_Graph, const Cluster & in_Area) : Graph(&in_Graph), Area(&in_Area) { }
+	};
+
 	struct Entrance
 	{
-		std::pair<Cluster, Cluster> Clusters;
+		// Indices of the two clusters in their level
+		std::pair<unsigned, unsigned> Clusters;
 		std::vector<Gate> Gates;
 
-		Entrance(const Cluster & in_Cluster1, const Cluster & in_Cluster2, 
-			const std::vector<Gate> in_Gates) :
-			Clusters(std::make_pair<Cluster, Cluster>(in_Cluster1, in_Cluster2)), Gates(in_Gates) { }
+		Entrance(const unsigned in_Cluster1, const unsigned in_Cluster2, const std::vector<Gate> & in_Gates) :
+			Clusters(in_Cluster1, in_Cluster2), Gates(in_Gates) { }
 
 		Entrance(Entrance && in_Entrance) : Clusters(std::move(in_Entrance.Clusters)), Gates(std::move(in_Entrance.Gates)) {}
 	};
 
+public:
+	// Search used for the paths inside a cluster
+	enum ClusterSearch { GridAStar, JumpPointSearch };
+	// Search used on the top level of the abstract queries
+	enum AbstractSearch { ForwardSearch, BidirectionalSearch };
+	// Kernel of the breadth first searches of the distance layers
+	enum WavefrontKernel { ScalarWavefront, SimdWavefront };
+
+	struct SearchStatistics
+	{
+		unsigned long long Searches;
+		unsigned long long Expansions;
+
+		SearchStatistics() : Searches(0), Expansions(0) { }
+	};
+
+private:
+	// Work on a cluster of the first level that WithFixedSearch gives the specialised search of the cluster's size
+	struct EntranceDistancesTask
+	{
+		const Navigator * Nav;
+		Cluster * Area;
+		SearchStatistics * Statistics;
+
+		EntranceDistancesTask(const Navigator & in_Nav, Cluster & io_Area, SearchStatistics & io_Statistics) : 
+			Nav(&in_Nav), Area(&io_Area), Statistics(&io_Statistics) { }
+
+		template<class SearchType>
+		void operator()(SearchType & io_Search) const { Nav->BuildEntranceDistances(*Area, io_Search, *Statistics); }
+	};
+
+	struct ClusterPathsTask
+	{
+		const Navigator * Nav;
+		const Cluster * Area;
+		ClusterPaths * Paths;
+		SearchStatistics * Statistics;
+
+		ClusterPathsTask(const Navigator & in_Nav, const Cluster & in_Area, ClusterPaths & out_Paths, SearchStatistics & io_Statistics) : 
+			Nav(&in_Nav), Area(&in_Area), Paths(&out_Paths), Statistics(&io_Statistics) { }
+
+		template<class SearchType>
+		void operator()(SearchType & io_Search) const { Nav->BuildClusterPaths(*Area, io_Search, *Paths, *Statistics); }
+	};
+
 private:
-	static const int M_MAXCLUSTERSIZE;
+	// Also the size of the largest FixedClusterSearch
+	static const int M_MAXCLUSTERSIZE = 20;
+	static const int M_CLUSTERGROUPSIZE;
+	static const unsigned M_MAXTOPCLUSTERS;
+	static const std::size_t M_CONCRETECACHEBUDGET;
+	static const std::size_t M_ABSTRACTCACHEBUDGET;
+	static const std::size_t M_CLUSTERPATHSBUDGET;
+	static const std::size_t M_DISTANCETABLEBUDGET;
+	static const std::size_t M_LANDMARKSBUDGET;
+	static const std::uint32_t M_CACHEMAGIC;
+	static const std::uint32_t M_CACHEVERSION;
 	unsigned m_MaxEntranceWidth;
+	// 0 uses one worker per hardware thread
+	unsigned m_NbWorkers;
+	int m_LevelLength;
+	int m_LevelWidth;
+	// 0 lets the size of the map decide how many abstract levels are built
+	int m_MaxDepth;
+	NodeStore m_Nodes;
+	NodeVector m_AbstractNodes;
+	SearchStatistics m_Statistics;
+	SearchContext m_SearchContext;
+	// The preprocessing workers other than the calling thread search with their own context
+	std::vector<SearchContext> m_WorkerContexts;
+	NodeVector m_PathBuffer;
+	NodeVector m_JumpPoints;
+	NodeVector m_SegmentBuffer;
+	NodeVector m_RefinedPath;
+	ClusterSearch m_ClusterSearch;
+	AbstractSearch m_AbstractSearch;
+	WavefrontKernel m_WavefrontKernel;
+	// The backward half of the bidirectional searches, empty until the first one
+	SearchContext m_BackwardContext;
+	// The clusters of every level tile the map row by row
 	std::vector<std::vector<Cluster>> m_Clusters;
+	std::vector<Tiling> m_Tilings;
 	std::vector<std::vector<Entrance>> m_Entrances;
-	std::vector<Graph> m_Graphs;
-	std::map<std::shared_ptr<Node>, std::map<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>>> m_Paths;
+	// The base level is searched on the implicit grid, the other levels on their frozen graph
+	GridGraph m_Grid;
+	// Connected component of every cell in the whole grid and in its cluster of the first level, GridGraph::M_NOCOMPONENT
+	// for the blocked cells. The clusters of the first level only depend on the size of the map so both are built with the grid.
+	std::vector<unsigned> m_Components;
+	std::vector<unsigned> m_ClusterComponents;
+	std::vector<CompactGraph> m_Graphs;
+	// Distance on the first abstract level between every pair of its entrances. The entrances are numbered cluster by cluster,
+	// the i-th entrance of the c-th cluster being m_TableOffsets[c] + i. Left empty when it does not fit in its budget.
+	MappedArray<float> m_DistanceTable;
+	std::vector<unsigned> m_TableOffsets;
+	// Lower bounds of the distances on the grid, and so of the distances on every abstract level
+	Landmarks m_Landmarks;
+	unsigned m_NbLandmarks;
+	// Paths from every cell to the goals registered before Init, the goals are kept across Reset
+	std::vector<Vector2> m_FlowGoals;
+	std::vector<FlowField> m_FlowFields;
+	// Bitboards of the distance layers, kept between the queries
+	Wavefront m_Wavefront;
+	// Concrete paths between base nodes and abstract paths between query nodes
+	PathCache<EncodedPath> m_ConcretePaths;
+	PathCache<NodeVector> m_AbstractPaths;
+
+	// The queries are answered on the flat grid, with their own context, until the hierarchy is ready
+	bool m_HierarchyReady;
+	mutable boost::mutex m_HierarchyMutex;
+	SearchContext m_FlatContext;
+	SearchStatistics m_FlatStatistics;
+	// Paths inside the first level clusters, published by the background worker as soon as a cluster is done.
+	// The pointers are only accessed with boost::atomic_load and boost::atomic_store.
+	std::vector<ClusterPathsPtr> m_ClusterPaths;
+	boost::thread m_Worker;
 
-	// Iterators to make the Navigator interruptible
-	std::vector<Cluster>::iterator m_CurrentCluster;
-	NodeIterator m_CurrentFirstNode;
-	NodeIterator m_CurrentSecondNode;
-	NodeIterator m_NodesEnd;
+	// The preprocessing of a level is saved in the cache directory, in a file named after the fingerprint of the level
+	std::string m_CacheDirectory;
+	std::string m_CachePath;
+	std::uint64_t m_Fingerprint;
+	bool m_LoadedFromCache;
+	bool m_SavedToCache;
 
 public:
-	Navigator() { }
+	Navigator() : m_NbWorkers(0), m_MaxDepth(0), m_ClusterSearch(GridAStar), m_AbstractSearch(ForwardSearch), m_WavefrontKernel(SimdWavefront), m_NbLandmarks(8), m_ConcretePaths(M_CONCRETECACHEBUDGET), m_AbstractPaths(M_ABSTRACTCACHEBUDGET),
+		m_HierarchyReady(false), m_Fingerprint(0), m_LoadedFromCache(false), m_SavedToCache(false) { }
+	~Navigator() { StopClusterProcessing(); }
 	void Init(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const int in_MaxEntranceWidth = 3);
 	void Reset();
 
+	// Returns once the level is loaded, the hierarchy and then the paths inside the clusters are built on the background thread.
+	// Until the hierarchy is ready the abstract paths are jump points of a search on the whole grid.
+	void InitInBackground(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const int in_MaxEntranceWidth = 3);
+	bool IsHierarchyReady() const;
+	const SearchStatistics & GetFlatSearchStatistics() const { return m_FlatStatistics; }
+
+	// Computes the paths inside the clusters on a background thread once Init is done. The concrete queries use the paths
+	// of a cluster as soon as they are published and never wait for them. Reset and the destructor stop the thread,
+	// they wait for the hierarchy to be ready first.
+	void StartClusterProcessing();
+	void StopClusterProcessing();
+	void WaitClusterProcessing();
+	unsigned GetNbProcessedClusters() const;
+
 	NodeVector ComputeAbstractPath(const Vector2 & in_Start, const Vector2 & in_Goal);
-	std::vector<Vector2> ComputeConcretePath(const std::shared_ptr<Node> & in_StartNode, const std::shared_ptr<Node> & in_GoalNode);
-	void ProcessClusters(const double in_Time);
+	std::vector<Vector2> ComputeConcretePath(const NodeId in_StartNode, const NodeId in_GoalNode);
+	void ComputeConcretePath(const NodeId in_StartNode, const NodeId in_GoalNode, std::vector<Vector2> & out_Path);
+
+	Node GetNode(const NodeId in_Node) const { return Node(m_Nodes.Levels[in_Node], m_Nodes.Heights[in_Node], m_Nodes.Position(in_Node)); }
+	Vector2 GetPosition(const NodeId in_Node) const { return m_Nodes.Position(in_Node); }
+	const SearchStatistics & GetSearchStatistics() const { return m_Statistics; }
+
+	// Length of the path between two positions without building it, infinity when there is none. Once the hierarchy is ready
+	// it goes through the entrances of the first level, as the paths of the hierarchy do, and takes a few table lookups.
+	// Until then, or when the map has too many entrances for the table, it is the length of the shortest path on the grid.
+	double GetDistance(const Vector2 & in_Start, const Vector2 & in_Goal);
+	// Whether a path links the two positions, answered from the connected components without searching
+	bool Reachable(const Vector2 & in_Start, const Vector2 & in_Goal) const;
+	bool HasDistanceTable() const { return !m_DistanceTable.empty(); }
+
+	// Registers a goal for the next Init, which builds the paths from every cell to it along with the hierarchy.
+	// Returns the index of the goal, the goals are kept across Reset.
+	unsigned AddFlowGoal(const Vector2 & in_Goal);
+	void ClearFlowGoals() { m_FlowGoals.clear(); }
+	// Once the hierarchy is ready, appends the cells of the shortest path from the position to the goal to out_Path by
+	// following its flow field, without any search. Returns false when the field is not built or the goal cannot be reached.
+	bool GetFlowPath(const unsigned in_Goal, const Vector2 & in_Start, std::vector<Vector2> & out_Path) const;
+	// Next cell on the shortest path from the position to the goal, the goal itself once there
+	bool GetFlowWaypoint(const unsigned in_Goal, const Vector2 & in_Position, Vector2 & out_Waypoint) const;
+	double GetFlowDistance(const unsigned in_Goal, const Vector2 & in_Position) const;
+
+	// Number of moves from each position to every cell of the map, out_Layers[i][x + y * width] for the i-th position and
+	// Wavefront::M_UNREACHED for the cells it cannot reach. Every move counts one, diagonal or not. This only needs the grid.
+	void ComputeDistanceLayers(const std::vector<Vector2> & in_Sources, std::vector<std::vector<unsigned short>> & out_Layers);
+
+	// Number of abstract levels built by Init. Setting 0 picks it from the size of the map, the setting is kept across Reset.
+	void SetMaxDepth(const int in_MaxDepth) { m_MaxDepth = in_MaxDepth; }
+	int GetDepth() const { return static_cast<int>(m_Graphs.size()) - 1; }
+
+	// Init loads the preprocessing of the level from this directory when it was saved there before, and saves it there
+	// otherwise. The directory must exist, an empty one disables the cache. The setting is kept across Reset.
+	void SetCacheDirectory(const std::string & in_Directory) { m_CacheDirectory = in_Directory; }
+	const std::string & GetCacheDirectory() const { return m_CacheDirectory; }
+	bool IsLoadedFromCache() const { return m_LoadedFromCache; }
+	// Whether the preprocessing built by the last Init was written to the cache directory
+	bool IsSavedToCache() const { return m_SavedToCache; }
+
+	// Threads sharing the preprocessing work of Init, the result does not depend on their number. Setting 0 uses
+	// one per hardware thread, the setting is kept across Reset.
+	void SetWorkerCount(const unsigned in_NbWorkers) { m_NbWorkers = in_NbWorkers; }
+	unsigned GetWorkerCount() const;
+
+	// Landmarks chosen by Init for the heuristic of the searches, fewer are kept on maps too large for their budget.
+	// The setting is kept across Reset.
+	void SetLandmarkCount(const unsigned in_NbLandmarks) { m_NbLandmarks = in_NbLandmarks; }
+	unsigned GetLandmarkCount() const { return m_Landmarks.NbLandmarks(); }
+
+	// Both searches give paths of the same cost, they may differ when several paths are the shortest
+	void SetClusterSearch(const ClusterSearch in_Search) { m_ClusterSearch = in_Search; }
+	ClusterSearch GetClusterSearch() const { return m_ClusterSearch; }
+
+	// Both searches give paths of the same cost, the bidirectional one expands fewer nodes between the far ends of a map
+	void SetAbstractSearch(const AbstractSearch in_Search) { m_AbstractSearch = in_Search; }
+	AbstractSearch GetAbstractSearch() const { return m_AbstractSearch; }
+
+	// Both kernels give the same layers, the SIMD one runs two positions at once when SSE2 is available
+	void SetWavefrontKernel(const WavefrontKernel in_Kernel) { m_WavefrontKernel = in_Kernel; }
+	WavefrontKernel GetWavefrontKernel() const { return m_WavefrontKernel; }
+
+	// The caches keep their budget across Reset
+	void SetPathCacheBudgets(const std::size_t in_ConcreteBudget, const std::size_t in_AbstractBudget)
+	{
+		m_ConcretePaths.SetBudget(in_ConcreteBudget);
+		m_AbstractPaths.SetBudget(in_AbstractBudget);
+	}
+	const PathCacheStatistics & GetConcretePathCacheStatistics() const { return m_ConcretePaths.GetStatistics(); }
+	const PathCacheStatistics & GetAbstractPathCacheStatistics() const { return m_AbstractPaths.GetStatistics(); }
 
 private:
-	double AStar(const std::shared_ptr<Node> & in_Start, const std::shared_ptr<Node> & in_Goal, 
-		Graph & in_Graph, IHeuristic && in_Heuristic);
+	template<class GraphType, class HeuristicType>
+	double AStar(const NodeId in_Start, const NodeId in_Goal, const GraphType & in_Graph, const HeuristicType & in_Heuristic);
+	template<class GraphType, class HeuristicType>
+	double AStar(const NodeId in_Start, const NodeId in_Goal, const GraphType & in_Graph, const HeuristicType & in_Heuristic,
+		SearchContext & io_Context, SearchStatistics & io_Statistics) const;
+	template<class HeuristicType>
+	double BidirectionalAStar(const NodeId in_Start, const NodeId in_Goal, const CompactGraph & in_Graph, const HeuristicType & in_Heuristic,
+		std::pair<NodeId, NodeId> & out_Meeting);
+	template<class GraphType>
+	bool Dijkstra(const NodeId in_Start, const GraphType & in_Graph);
+	template<class GraphType>
+	bool Dijkstra(const NodeId in_Start, const GraphType & in_Graph, SearchContext & io_Context, SearchStatistics & io_Statistics) const;
+	template<class HeuristicType>
+	void Expand(const NodeId in_Node, const GridGraph::Window & in_Window, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+		SearchContext & io_Context) const;
+	template<class HeuristicType>
+	void Expand(const NodeId in_Node, const GridGraph::JumpWindow & in_Window, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+		SearchContext & io_Context) const;
+	template<class HeuristicType>
+	void Expand(const NodeId in_Node, const CompactGraph & in_Graph, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+		SearchContext & io_Context) const;
+	template<class HeuristicType>
+	void Expand(const NodeId in_Node, const ClusterGraph & in_Graph, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+		SearchContext & io_Context) const;
+	template<class HeuristicType>
+	void Relax(const NodeId in_Node, const NodeId in_Neighbor, const double in_Cost, const Vector2 & in_GoalPos, const HeuristicType & in_Heuristic, 
+		SearchContext & io_Context) const;
+	void ExtractPath(const NodeId in_Goal, NodeVector & out_Path) const;
+	void ExtractPath(const NodeId in_Goal, const SearchContext & in_Context, NodeVector & out_Path) const;
+	void ExtractBidirectionalPath(const std::pair<NodeId, NodeId> & in_Meeting, NodeVector & out_Path) const;
+	void ExtractJumpPath(const NodeId in_Goal, const SearchContext & in_Context, NodeVector & out_Path);
+	double SearchCluster(const NodeId in_Start, const NodeId in_Goal, const Cluster & in_Cluster);
+	double SearchFlat(const NodeId in_Start, const NodeId in_Goal);
+	EncodedPath EncodePath(const NodeVector & in_Path) const;
 
+	NodeId GetAbstractNode(const Vector2 & in_Position);
+	NodeId BaseNode(const Vector2 & in_Position) const;
+	NodeId BaseNode(const NodeId in_Node) const;
+	NodeId QueryNode(const Vector2 & in_Position) const;
+	Vector2 LevelCell(const Vector2 & in_Position) const;
+	unsigned ClusterIndex(const Vector2 & in_Cell, const int in_Level) const;
+	Cluster & ClusterAt(const Vector2 & in_Cell, const int in_Level = 1);
+	bool Contains(const Cluster & in_Cluster, const NodeId in_Node) const;
+
+	void LoadLevel(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const int in_MaxEntranceWidth);
+	void BuildInBackground();
 	void AbstractMaze();
-	bool Adjacent(const Cluster & in_Cluster1, const Cluster & in_Cluster2, Adjacency & out_Adjacency) const;
 	void BuildClusters(const int in_Level);
 	int ClusterSize(const int in_Size) const;
+	bool NeedsUpperLevel() const;
+	void BuildUpperClusters(const int in_Level);
+	void BuildUpperEntrances(const int in_Level);
+	void BuildUpperGraph(const int in_Level);
+	void BuildUpperPaths(Cluster & io_Cluster, SearchContext & io_Context, SearchStatistics & io_Statistics) const;
 	void BuildEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2, const int in_Level, const Adjacency in_Adjacency);
 	void BuildSideEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2, std::vector<Gate> & out_Gates);
 	void BuildTopEntrances(Cluster & in_Cluster1, Cluster & in_Cluster2, std::vector<Gate> & out_Gates);
+	void SelectGates(Cluster & in_Cluster1, Cluster & in_Cluster2, const std::vector<std::vector<Gate>> & in_PotentialGates, 
+		std::vector<Gate> & out_Gates);
+	void AddGate(Cluster & in_Cluster1, Cluster & in_Cluster2, const Gate & in_BaseGate, std::vector<Gate> & out_Gates);
 	void BuildGraph();
 	void Preprocess();
-	void ConnectLevelNodes();
-	void BuildLocalGraph(const int in_Length, const int in_Width, const NodeVector & in_Nodes, Graph & out_LocalGraph);
-	
-	void AddIntraEdges(const double in_TimeLimit);
-	
-	void ConnectToBorder(const std::shared_ptr<Node> & in_Node, Cluster & in_Cluster);
-	double SearchForDistance(const std::shared_ptr<Node> & in_Node1, const std::shared_ptr<Node> & in_Node2, const Cluster & in_Cluster);
+	unsigned WorkersFor(const unsigned in_NbTasks) const;
+	unsigned PrepareWorkers(const unsigned in_NbTasks);
+	template<class Op>
+	void ForEachClusterParallel(std::vector<Cluster> & io_Clusters, Op in_Func);
+	template<class Op>
+	void ForEachClusterOnWorkers(std::vector<Cluster> & io_Clusters, const unsigned in_NbWorkers, Op in_Func);
+	void IndexEntrances();
+	void BuildLandmarks();
+	void BuildFlowFields();
+	const FlowField * GetFlowField(const unsigned in_Goal) const;
+	void BuildDistanceTable();
+	void ConnectLevelNodes(Graph & out_Graph);
+	GridGraph::Window ClusterWindow(const Cluster & in_Cluster) const;
+	unsigned CellInCluster(const Cluster & in_Cluster, const NodeId in_Node) const;
+	void LabelComponents();
+	static bool SameComponent(const std::vector<unsigned> & in_Components, const NodeId in_BaseNode1, const NodeId in_BaseNode2);
+	template<class Op>
+	void WithFixedSearch(const Cluster & in_Cluster, Op & io_Op) const;
+	void BuildEntranceDistances(Cluster & io_Cluster, SearchStatistics & io_Statistics) const;
+	template<class SearchType>
+	void BuildEntranceDistances(Cluster & io_Cluster, SearchType & io_Search, SearchStatistics & io_Statistics) const;
+	template<class SearchType>
+	void BuildClusterPaths(const Cluster & in_Cluster, SearchType & io_Search, ClusterPaths & out_Paths, SearchStatistics & io_Statistics) const;
+
+	void ProcessClusters();
 
-	NodeIterator FindCorrespondingBaseNode(Cluster & in_Cluster, const std::shared_ptr<Node> & in_LevelNode) const;
-	NodeIterator FindCorrespondingBaseNode(Cluster & in_Cluster, const Node & in_LevelNode) const;
+	bool LoadCache();
+	bool ReadCache(const void * in_Data, const std::size_t in_Size, const boost::shared_ptr<const void> & in_Mapping);
+	bool ValidCluster(const Cluster & in_Cluster, const bool in_FirstLevel, const NodeStore & in_Nodes) const;
+	bool SaveCache() const;
+	
+	void ConnectToBorder(const NodeId in_Node, Cluster & in_Cluster);
+	void ConnectToUpperBorder(const NodeId in_Node, const NodeId in_Other, const Cluster & in_Cluster);
+	void RefinePath(const int in_Level, const NodeVector & in_Path, NodeVector & out_Path);
 };
 
 #endif // NAVIGATOR_H
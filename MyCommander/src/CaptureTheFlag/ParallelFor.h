@@ -0,0 +1,44 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <boost/thread.hpp>
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* ParallelFor
+* Calls in_Func(index, worker) for every index in [0, in_Count[ on in_NbWorkers threads.
+* Worker w gets the indices w, w + in_NbWorkers, ... so the split does not depend on the timing,
+* and worker 0 is the calling thread. The call returns once every index was processed. The threads are joined
+* before any exception leaves it, in_Func and the state it refers to outlive them.
+*/
+template<class Op>
+void ParallelFor(const unsigned in_Count, const unsigned in_NbWorkers, Op in_Func)
+{
+	boost::thread_group l_Threads;
+	for(unsigned w = 1; w < in_NbWorkers && w < in_Count; ++w)
+	{
+		l_Threads.create_thread([w, in_Count, in_NbWorkers, &in_Func]()
+		{
+			for(unsigned i = w; i < in_Count; i += in_NbWorkers)
+				in_Func(i, w);
+		});
+	}
+
+	try
+	{
+		for(unsigned i = 0; i < in_Count; i += in_NbWorkers)
+			in_Func(i, 0);
+		l_Threads.join_all();
+	}
+	catch(...)
+	{
+		// join is an interruption point
+		boost::this_thread::disable_interruption l_NoInterruption;
+		l_Threads.join_all();
+		throw;
+	}
+}
+
+#endif // PARALLEL_FOR_H
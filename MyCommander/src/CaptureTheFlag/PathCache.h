@@ -0,0 +1,153 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Memory held by a path of node indices besides the vector itself
+inline std::size_t PathBytes(const std::vector<std::uint32_t> & in_Path)
+{
+	return in_Path.size() * sizeof(std::uint32_t);
+}
+
+struct PathCacheStatistics
+{
+	unsigned long long Hits;
+	unsigned long long Misses;
+	unsigned long long Evictions;
+
+	PathCacheStatistics() : Hits(0), Misses(0), Evictions(0) { }
+};
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* PathCache
+* Paths between pairs of nodes, kept within a byte budget. When the budget is exceeded the least
+* recently used paths are evicted. A path is stored once for both directions, in the direction it
+* was found. Looking up a path never inserts anything.
+* PathBytes(path) must give the memory held by a path besides its own size.
+*/
+template<class PathType>
+class PathCache
+{
+public:
+	typedef std::uint32_t NodeId;
+	typedef PathType Path;
+
+	typedef PathCacheStatistics Statistics;
+
+private:
+	typedef std::uint64_t Key;
+
+	struct Entry
+	{
+		Key PairKey;
+		NodeId Start;
+		Path Nodes;
+
+		Entry(const Key in_Key, const NodeId in_Start, const Path & in_Nodes) : PairKey(in_Key), Start(in_Start), Nodes(in_Nodes) { }
+	};
+
+	typedef std::list<Entry> EntryList;
+	typedef typename EntryList::iterator EntryIterator;
+
+private:
+	// Most recently used first
+	EntryList m_Entries;
+	std::unordered_map<Key, EntryIterator> m_Index;
+	std::size_t m_Budget;
+	std::size_t m_Bytes;
+	Statistics m_Statistics;
+
+public:
+	explicit PathCache(const std::size_t in_Budget = 4 * 1024 * 1024) : m_Budget(in_Budget), m_Bytes(0) { }
+
+	// Finds the path between in_Start and in_Goal. When out_Reversed is true the path goes from in_Goal to in_Start.
+	const Path * Find(const NodeId in_Start, const NodeId in_Goal, bool & out_Reversed)
+	{
+		auto l_It = m_Index.find(MakeKey(in_Start, in_Goal));
+		if(l_It == m_Index.end())
+		{
+			++m_Statistics.Misses;
+			return nullptr;
+		}
+
+		++m_Statistics.Hits;
+		m_Entries.splice(m_Entries.begin(), m_Entries, l_It->second);
+		out_Reversed = l_It->second->Start != in_Start;
+		return &l_It->second->Nodes;
+	}
+
+	void Store(const NodeId in_Start, const NodeId in_Goal, const Path & in_Path)
+	{
+		const Key l_Key = MakeKey(in_Start, in_Goal);
+		auto l_It = m_Index.find(l_Key);
+		if(l_It != m_Index.end())
+			Erase(l_It->second);
+
+		if(EntrySize(in_Path) > m_Budget)
+			return;
+
+		m_Entries.push_front(Entry(l_Key, in_Start, in_Path));
+		m_Index[l_Key] = m_Entries.begin();
+		m_Bytes += EntrySize(in_Path);
+
+		Evict();
+	}
+
+	void SetBudget(const std::size_t in_Budget)
+	{
+		m_Budget = in_Budget;
+		Evict();
+	}
+
+	void Clear()
+	{
+		m_Entries.clear();
+		m_Index.clear();
+		m_Bytes = 0;
+		m_Statistics = Statistics();
+	}
+
+	std::size_t Budget() const { return m_Budget; }
+	std::size_t Bytes() const { return m_Bytes; }
+	unsigned Size() const { return static_cast<unsigned>(m_Index.size()); }
+	const Statistics & GetStatistics() const { return m_Statistics; }
+
+private:
+	static Key MakeKey(const NodeId in_Node1, const NodeId in_Node2)
+	{
+		return in_Node1 < in_Node2 ? (Key(in_Node1) << 32) | in_Node2 : (Key(in_Node2) << 32) | in_Node1;
+	}
+
+	// Approximation of the memory held by an entry: the list node, the index node and the path itself
+	static std::size_t EntrySize(const Path & in_Path)
+	{
+		return sizeof(Entry) + 2 * sizeof(void*) + sizeof(std::pair<Key, EntryIterator>) + 2 * sizeof(void*)
+			+ PathBytes(in_Path);
+	}
+
+	void Erase(const EntryIterator & in_It)
+	{
+		m_Bytes -= EntrySize(in_It->Nodes);
+		m_Index.erase(in_It->PairKey);
+		m_Entries.erase(in_It);
+	}
+
+	void Evict()
+	{
+		while(m_Bytes > m_Budget && !m_Entries.empty())
+		{
+			Erase(--m_Entries.end());
+			++m_Statistics.Evictions;
+		}
+	}
+};
+
+#endif // PATH_CACHE_H
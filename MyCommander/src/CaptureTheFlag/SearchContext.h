@@ -0,0 +1,95 @@
+#ifndef SEARCH_CONTEXT_H
+#define SEARCH_CONTEXT_H
+
+#include <limits>
+#include <vector>
+
+#include "IndexedHeap.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* SearchContext
+* Scratch memory shared by the searches of a Navigator, each preprocessing worker has its own. The per-node slots are allocated once
+* per level and are only valid when their stamp matches the current generation, so starting a new
+* search never has to touch them.
+*/
+class SearchContext
+{
+public:
+	static const unsigned M_NOPARENT = 0xFFFFFFFF;
+
+private:
+	struct Slot
+	{
+		unsigned Stamp;
+		unsigned Parent;
+		double Cost;
+		bool Closed;
+	};
+
+private:
+	std::vector<Slot> m_Slots;
+	IndexedHeap<double> m_Opened;
+	unsigned m_Generation;
+
+public:
+	SearchContext() : m_Generation(0) { }
+
+	// Makes room for in_NbNodes nodes. Nothing is allocated when the context is already big enough.
+	void Resize(const unsigned in_NbNodes)
+	{
+		if(in_NbNodes <= m_Slots.size())
+			return;
+
+		Slot l_EmptySlot = { 0, M_NOPARENT, std::numeric_limits<double>::infinity(), false };
+		m_Slots.assign(in_NbNodes, l_EmptySlot);
+		m_Opened.Reset(in_NbNodes);
+		m_Generation = 0;
+	}
+
+	unsigned Capacity() const { return static_cast<unsigned>(m_Slots.size()); }
+
+	void NewSearch()
+	{
+		m_Opened.Clear();
+
+		// The stamps only need to be wiped when the generation counter wraps around
+		if(++m_Generation == 0)
+		{
+			for(auto l_It = m_Slots.begin(); l_It != m_Slots.end(); ++l_It)
+				l_It->Stamp = 0;
+			m_Generation = 1;
+		}
+	}
+
+	IndexedHeap<double> & Opened() { return m_Opened; }
+
+	bool Visited(const unsigned in_Index) const { return m_Slots[in_Index].Stamp == m_Generation; }
+	bool Closed(const unsigned in_Index) const { return Visited(in_Index) && m_Slots[in_Index].Closed; }
+	unsigned Parent(const unsigned in_Index) const { return Visited(in_Index) ? m_Slots[in_Index].Parent : M_NOPARENT; }
+
+	double Cost(const unsigned in_Index) const
+	{
+		return Visited(in_Index) ? m_Slots[in_Index].Cost : std::numeric_limits<double>::infinity();
+	}
+
+	void Close(const unsigned in_Index)
+	{
+		m_Slots[in_Index].Closed = true;
+	}
+
+	// Records a better way to reach a node and queues it with the given priority
+	void Open(const unsigned in_Index, const double in_Cost, const unsigned in_Parent, const double in_Priority)
+	{
+		Slot & l_Slot = m_Slots[in_Index];
+		l_Slot.Stamp = m_Generation;
+		l_Slot.Parent = in_Parent;
+		l_Slot.Cost = in_Cost;
+		l_Slot.Closed = false;
+		m_Opened.Push(in_Index, in_Priority);
+	}
+};
+
+#endif // SEARCH_CONTEXT_H
@@ -0,0 +1,222 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAVEFRONT_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "GridGraph.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* Wavefront
+* Breadth first search of the GridGraph from several sources at once on bitboards laid out like its packed rows.
+* A step dilates the frontier of every source with shifts and ors, horizontally then vertically, and keeps the
+* walkable cells it did not visit yet. The cells are linked like in the searches but every move is one step, so
+* the layers hold the number of moves from the source to each cell rather than the cost of the path.
+* The kernel is written once over its lanes: a 64-bit word of one source, or an SSE2 vector holding the same word
+* of two sources whose bitboards are interleaved.
+*/
+
+// One word of the bitboard of a single source
+struct ScalarLanes
+{
+	typedef std::uint64_t Word;
+	enum { M_NBLANES = 1 };
+
+	static Word Load(const std::uint64_t * in_Words) { return *in_Words; }
+	static void Store(std::uint64_t * out_Words, const Word in_Word) { *out_Words = in_Word; }
+	static Word Zero() { return 0; }
+	static Word Or(const Word in_First, const Word in_Second) { return in_First | in_Second; }
+	// Cells of in_Cells that are walkable and not in in_Visited
+	static Word Reach(const Word in_Cells, const Word in_Walkable, const Word in_Visited) { return in_Cells & in_Walkable & ~in_Visited; }
+	static bool IsZero(const Word in_Word) { return !in_Word; }
+
+	// The word and its left and right neighbors, the bits of the words around it carry over
+	static Word Dilate(const Word in_Left, const Word in_Word, const Word in_Right)
+	{
+		return in_Word | in_Word << 1 | in_Word >> 1 | in_Left >> 63 | in_Right << 63;
+	}
+};
+
+#ifdef WAVEFRONT_SSE2
+// The same word of two sources, the shifts stay inside the 64-bit lanes
+struct Sse2Lanes
+{
+	typedef __m128i Word;
+	enum { M_NBLANES = 2 };
+
+	static Word Load(const std::uint64_t * in_Words) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(in_Words)); }
+	static void Store(std::uint64_t * out_Words, const Word in_Word) { _mm_storeu_si128(reinterpret_cast<__m128i *>(out_Words), in_Word); }
+	static Word Zero() { return _mm_setzero_si128(); }
+	static Word Or(const Word in_First, const Word in_Second) { return _mm_or_si128(in_First, in_Second); }
+	static Word Reach(const Word in_Cells, const Word in_Walkable, const Word in_Visited) { return _mm_andnot_si128(in_Visited, _mm_and_si128(in_Cells, in_Walkable)); }
+	static bool IsZero(const Word in_Word) { return _mm_movemask_epi8(_mm_cmpeq_epi8(in_Word, _mm_setzero_si128())) == 0xFFFF; }
+
+	static Word Dilate(const Word in_Left, const Word in_Word, const Word in_Right)
+	{
+		return _mm_or_si128(_mm_or_si128(_mm_or_si128(in_Word, _mm_slli_epi64(in_Word, 1)), _mm_srli_epi64(in_Word, 1)),
+			_mm_or_si128(_mm_srli_epi64(in_Left, 63), _mm_slli_epi64(in_Right, 63)));
+	}
+};
+#else
+// Without SSE2 the vector kernel runs the scalar one
+typedef ScalarLanes Sse2Lanes;
+#endif
+
+class Wavefront
+{
+public:
+	typedef GridGraph::NodeId NodeId;
+
+	// Also the largest number of steps, the cells farther away are left unreached
+	static const unsigned short M_UNREACHED = 0xFFFF;
+
+private:
+	int m_Length;
+	int m_Width;
+	unsigned m_WordsPerRow;
+	// Every board holds the words of a group of sources interleaved, the lanes of a word are consecutive
+	std::vector<std::uint64_t> m_Walkable;
+	std::vector<std::uint64_t> m_Visited;
+	std::vector<std::uint64_t> m_Frontier;
+	std::vector<std::uint64_t> m_Dilated;
+	std::vector<std::uint64_t> m_Next;
+
+public:
+	Wavefront() : m_Length(0), m_Width(0), m_WordsPerRow(0) { }
+
+	// Number of steps from each source to every cell, out_Layers[i][cell] for the i-th source. The blocked sources reach no cell.
+	template<class Lanes>
+	void Run(const GridGraph & in_Grid, const std::vector<NodeId> & in_Sources, std::vector<std::vector<unsigned short>> & out_Layers)
+	{
+		Load<Lanes>(in_Grid);
+		out_Layers.resize(in_Sources.size());
+		for(auto l_It = out_Layers.begin(); l_It != out_Layers.end(); ++l_It)
+			l_It->assign(m_Length * m_Width, static_cast<unsigned short>(M_UNREACHED));
+
+		for(unsigned l_First = 0; l_First < in_Sources.size(); l_First += Lanes::M_NBLANES)
+			RunGroup<Lanes>(in_Sources, l_First, out_Layers);
+	}
+
+private:
+	template<class Lanes>
+	void Load(const GridGraph & in_Grid)
+	{
+		m_Length = in_Grid.Length();
+		m_Width = in_Grid.Width();
+		m_WordsPerRow = in_Grid.WordsPerRow();
+
+		const unsigned l_NbWords = m_WordsPerRow * m_Length;
+		m_Walkable.resize(l_NbWords * Lanes::M_NBLANES);
+		for(unsigned i = 0; i < l_NbWords; ++i)
+			std::fill(m_Walkable.begin() + i * Lanes::M_NBLANES, m_Walkable.begin() + (i + 1) * Lanes::M_NBLANES, in_Grid.Word(i));
+		m_Visited.resize(m_Walkable.size());
+		m_Frontier.resize(m_Walkable.size());
+		m_Dilated.resize(m_Walkable.size());
+		m_Next.resize(m_Walkable.size());
+	}
+
+	// The frontier only spans the rows it reached, it grows by one row on each side at most on every step
+	template<class Lanes>
+	void RunGroup(const std::vector<NodeId> & in_Sources, const unsigned in_First, std::vector<std::vector<unsigned short>> & io_Layers)
+	{
+		const unsigned l_NbLanes = Lanes::M_NBLANES;
+		const unsigned l_NbSources = std::min<unsigned>(l_NbLanes, static_cast<unsigned>(in_Sources.size()) - in_First);
+		std::fill(m_Visited.begin(), m_Visited.end(), 0);
+		std::fill(m_Frontier.begin(), m_Frontier.end(), 0);
+		int l_MinY = m_Length, l_MaxY = -1;
+
+		for(unsigned l_Lane = 0; l_Lane < l_NbSources; ++l_Lane)
+		{
+			const NodeId l_Source = in_Sources[in_First + l_Lane];
+			const int l_X = l_Source % m_Width, l_Y = l_Source / m_Width;
+			const unsigned l_Index = (l_Y * m_WordsPerRow + l_X / 64) * l_NbLanes + l_Lane;
+			if(!((m_Walkable[l_Index] >> (l_X % 64)) & 1))
+				continue;
+
+			m_Frontier[l_Index] |= std::uint64_t(1) << (l_X % 64);
+			m_Visited[l_Index] |= std::uint64_t(1) << (l_X % 64);
+			io_Layers[in_First + l_Lane][l_Source] = 0;
+			l_MinY = std::min(l_MinY, l_Y);
+			l_MaxY = std::max(l_MaxY, l_Y);
+		}
+
+		for(unsigned short l_Step = 1; l_MinY <= l_MaxY && l_Step < M_UNREACHED; ++l_Step)
+		{
+			for(int y = l_MinY; y <= l_MaxY; ++y)
+			{
+				for(unsigned w = 0; w < m_WordsPerRow; ++w)
+				{
+					const unsigned l_Index = (y * m_WordsPerRow + w) * l_NbLanes;
+					Lanes::Store(&m_Dilated[l_Index], Lanes::Dilate(w ? Lanes::Load(&m_Frontier[l_Index - l_NbLanes]) : Lanes::Zero(),
+						Lanes::Load(&m_Frontier[l_Index]), w + 1 < m_WordsPerRow ? Lanes::Load(&m_Frontier[l_Index + l_NbLanes]) : Lanes::Zero()));
+				}
+			}
+
+			// Every row of the new frontier is written, the rows read on the next step are among them
+			const int l_FirstY = std::max(l_MinY - 1, 0), l_LastY = std::min(l_MaxY + 1, m_Length - 1);
+			int l_NextMinY = m_Length, l_NextMaxY = -1;
+			for(int y = l_FirstY; y <= l_LastY; ++y)
+			{
+				for(unsigned w = 0; w < m_WordsPerRow; ++w)
+				{
+					const unsigned l_Index = (y * m_WordsPerRow + w) * l_NbLanes;
+					typename Lanes::Word l_Cells = Lanes::Zero();
+					for(int l_Y = std::max(y - 1, l_MinY); l_Y <= std::min(y + 1, l_MaxY); ++l_Y)
+						l_Cells = Lanes::Or(l_Cells, Lanes::Load(&m_Dilated[(l_Y * m_WordsPerRow + w) * l_NbLanes]));
+
+					const typename Lanes::Word l_Visited = Lanes::Load(&m_Visited[l_Index]);
+					const typename Lanes::Word l_Reached = Lanes::Reach(l_Cells, Lanes::Load(&m_Walkable[l_Index]), l_Visited);
+					Lanes::Store(&m_Next[l_Index], l_Reached);
+					if(Lanes::IsZero(l_Reached))
+						continue;
+
+					Lanes::Store(&m_Visited[l_Index], Lanes::Or(l_Visited, l_Reached));
+					l_NextMinY = std::min(l_NextMinY, y);
+					l_NextMaxY = y;
+					for(unsigned l_Lane = 0; l_Lane < l_NbSources; ++l_Lane)
+						WriteStep(m_Next[l_Index + l_Lane], y * m_Width + w * 64, l_Step, io_Layers[in_First + l_Lane]);
+				}
+			}
+
+			m_Frontier.swap(m_Next);
+			l_MinY = l_NextMinY;
+			l_MaxY = l_NextMaxY;
+		}
+	}
+
+	static void WriteStep(std::uint64_t in_Cells, const unsigned in_FirstCell, const unsigned short in_Step, std::vector<unsigned short> & io_Layer)
+	{
+		for(; in_Cells; in_Cells &= in_Cells - 1)
+			io_Layer[in_FirstCell + LowestBit(in_Cells)] = in_Step;
+	}
+
+	static unsigned LowestBit(const std::uint64_t in_Word)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long l_Bit = 0;
+		_BitScanForward64(&l_Bit, in_Word);
+		return l_Bit;
+#elif defined(__GNUC__)
+		return __builtin_ctzll(in_Word);
+#else
+		unsigned l_Bit = 0;
+		while(!((in_Word >> l_Bit) & 1))
+			++l_Bit;
+		return l_Bit;
+#endif
+	}
+};
+
+#endif // WAVEFRONT_H
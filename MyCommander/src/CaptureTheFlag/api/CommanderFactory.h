@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <utility>
 #include <functional>
 
 #include "Commander.h"
@@ -12,6 +13,8 @@ class CommanderFactory
 {
 public:
     typedef std::function<Commander*()> Creator;
+    // Preprocesses a level saved as JSON into a cache directory ahead of the matches. Returns false when it could not.
+    typedef std::function<bool(const std::string& levelFile, const std::string& cacheDirectory)> Baker;
 
     void registerCommander(const std::string& name, Creator creator)
     {
@@ -36,6 +39,29 @@ public:
         return m_creators.find(name) != m_creators.end();
     }
 
+    // Only the commanders that cache their preprocessing register a baker, with the cache directory they read at startup.
+    void registerBaker(const std::string& name, Baker baker, const std::string& cacheDirectory)
+    {
+        m_bakers[name] = std::make_pair(baker, cacheDirectory);
+    }
+
+    bool canBake(const std::string& name) const
+    {
+        return m_bakers.find(name) != m_bakers.end();
+    }
+
+    bool bake(const std::string& name, const std::string& levelFile, const std::string& cacheDirectory) const
+    {
+        auto iter = m_bakers.find(name);
+        return iter != m_bakers.end() && iter->second.first(levelFile, cacheDirectory);
+    }
+
+    std::string getCacheDirectory(const std::string& name) const
+    {
+        auto iter = m_bakers.find(name);
+        return iter != m_bakers.end() ? iter->second.second : std::string();
+    }
+
     size_t getCommanderCount() const
     {
         return m_creators.size();
@@ -60,6 +86,7 @@ public:
 
 private:
     std::map< std::string, Creator> m_creators;
+    std::map< std::string, std::pair<Baker, std::string> > m_bakers;
 };
 
 class CommanderAutoRegister
@@ -71,7 +98,18 @@ public:
     }
 };
 
+class BakerAutoRegister
+{
+public:
+    BakerAutoRegister(const std::string& name, CommanderFactory::Baker baker, const std::string& cacheDirectory)
+    {
+        CommanderFactory::getInstance().registerBaker(name, baker, cacheDirectory);
+    }
+};
+
 #define REGISTER_COMMANDER(COMMANDER) static CommanderAutoRegister s_autoRegister##COMMANDER(#COMMANDER, [] () { return new COMMANDER(); });
+// The cache directory is copied when the statics are initialized, it must be defined before this line in its file
+#define REGISTER_BAKER(COMMANDER, BAKER, CACHE_DIRECTORY) static BakerAutoRegister s_bakerAutoRegister##COMMANDER(#COMMANDER, BAKER, CACHE_DIRECTORY);
 
 
 #endif // COMMANDERFACTORY_H
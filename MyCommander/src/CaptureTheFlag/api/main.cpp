@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
 
 #include "Handshaking.h"
@@ -13,6 +14,44 @@ using namespace std;
 using namespace boost::asio;
 using namespace boost::asio::ip;
 
+// Preprocesses every level of a directory into the cache of a commander so that it does not have to at startup
+int bake(const string& commanderName, const string& levelDirectory, const string& cacheDirectory)
+{
+    namespace fs = boost::filesystem;
+    CommanderFactory& commanderFactory = CommanderFactory::getInstance();
+    if (!commanderFactory.canBake(commanderName))
+    {
+        cerr << "Commander '" << commanderName << "' has nothing to bake." << endl;
+        return 1;
+    }
+
+    boost::system::error_code ec;
+    fs::create_directories(cacheDirectory, ec);
+    if (!fs::is_directory(levelDirectory, ec))
+    {
+        cerr << "Unable to read " << levelDirectory << endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for (fs::directory_iterator it(levelDirectory), end; it != end; ++it)
+    {
+        if (!fs::is_regular_file(it->status()) || it->path().extension() != ".json")
+            continue;
+
+        if (commanderFactory.bake(commanderName, it->path().string(), cacheDirectory))
+        {
+            cout << "Baked " << it->path().string() << endl;
+        }
+        else
+        {
+            cerr << "Unable to bake " << it->path().string() << endl;
+            ++failures;
+        }
+    }
+    return failures ? 1 : 0;
+}
+
 int main(int argc, char** argv)
 {
     string HOST = "localhost";
@@ -21,7 +60,17 @@ int main(int argc, char** argv)
 
     CommanderFactory& commanderFactory = CommanderFactory::getInstance();
 
-    if ((argc == 1) && (commanderFactory.getCommanderCount() == 1))
+    if ((argc >= 3) && (argc <= 5) && (string(argv[1]) == "--bake"))
+    {
+        if ((argc < 5) && (commanderFactory.getCommanderCount() != 1))
+        {
+            cerr << "Usage: client --bake <level_directory> <cache_directory> <commander_name>" << endl;
+            return 1;
+        }
+        const string bakerName = (argc == 5) ? argv[4] : commanderFactory.getCommanderNames()[0];
+        return bake(bakerName, argv[2], (argc > 3) ? argv[3] : commanderFactory.getCacheDirectory(bakerName));
+    }
+    else if ((argc == 1) && (commanderFactory.getCommanderCount() == 1))
     {
         commanderName = commanderFactory.getCommanderNames()[0];
     }
@@ -45,6 +94,7 @@ int main(int argc, char** argv)
     {
         cerr << "Usage: client [<hostname> <port>] [<commander_name>]" << endl;
         cerr << "eg. client localhost 41041 MyCommander" << endl;
+        cerr << "       client --bake <level_directory> [<cache_directory> [<commander_name>]]" << endl;
         return 1;
     }
 
@@ -0,0 +1,33 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdlib>
+#include <new>
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* AllocationCounter
+* Replaces the global operator new to count the heap allocations made by the code under test.
+* It must only be included by one translation unit of the test project.
+* The count is not synchronized, it is only exact while the code under test runs on a single thread.
+*/
+
+unsigned long long g_NbAllocations = 0;
+
+void* operator new(std::size_t in_Size)
+{
+	++g_NbAllocations;
+	void* l_Memory = std::malloc(in_Size ? in_Size : 1);
+	if(!l_Memory)
+		throw std::bad_alloc();
+	return l_Memory;
+}
+
+void operator delete(void* in_Memory) throw()
+{
+	std::free(in_Memory);
+}
+
+#endif // ALLOCATION_COUNTER_H
@@ -1,7 +1,11 @@
 #ifndef NAVIGATION_FIXTURE_H
 #define NAVIGATION_FIXTURE_H
 
+#include <cmath>
+#include <cstdio>
 #include <memory>
+#include <queue>
+#include <random>
 
 #include "Navigator.h"
 #include "Navigator.cpp"
@@ -9,6 +13,7 @@
 #include "api\GameInfo.h"
 #include "api\json.h"
 
+#include "AllocationCounter.h"
 #include "Utils.h"
 
 /*
@@ -20,8 +25,21 @@
 */
 struct NavigationFixture
 {
+	struct HeuristicBenchmark
+	{
+		double Cost;
+		double Duration;
+		unsigned long long Expansions;
+	};
+
 	static const double MAX_INIT_TIME;
 	static const double MAX_SEARCH_TIME;
+	static const double MIN_EXPANSIONS_PER_MS;
+	static const double MAX_LATENCY_DRIFT;
+	static const double MAX_QUERY_OVERHEAD;
+	static const double MAX_HIERARCHY_OVERCOST;
+	static const double MAX_BACKGROUND_INIT_RATIO;
+	static const double MAX_CACHE_LOAD_RATIO;
 
 	Navigator m_Nav;
 
@@ -58,7 +76,7 @@ struct NavigationFixture
 		{
 			m_Nav.Init(in_Level, in_Length, in_Width, in_MaxEntranceWidth);
 			l_Start = boost::chrono::high_resolution_clock::now();
-			std::vector<std::shared_ptr<Navigator::Node>> l_AbstractPath(
+			Navigator::NodeVector l_AbstractPath(
 				m_Nav.ComputeAbstractPath(in_SmallTest ? m_StartPos : Vector2(2.f,3.f), 
 				in_SmallTest ? m_GoalPos : Vector2(70.f,48.f)));
 			l_AbstractDurations[i] = boost::chrono::high_resolution_clock::now() - l_Start;
@@ -67,7 +85,7 @@ struct NavigationFixture
 			for(unsigned j = 0; j < l_AbstractPath.size()-1; ++j)
 			{
 				l_Start = boost::chrono::high_resolution_clock::now();
-				vector<Vector2> l_Path(m_Nav.ComputeConcretePath(std::move(l_AbstractPath[j]), std::move(l_AbstractPath[j+1])));
+				vector<Vector2> l_Path(m_Nav.ComputeConcretePath(l_AbstractPath[j], l_AbstractPath[j+1]));
 				l_ConcreteDurations.push_back(boost::chrono::high_resolution_clock::now() - l_Start);
 			}
 			m_Nav.Reset();
@@ -98,9 +116,1120 @@ struct NavigationFixture
 
 		return ComputeMean(l_AbstractTimes) < MAX_SEARCH_TIME && ComputeMean(l_ConcreteTimes) < MAX_SEARCH_TIME;
 	}
+
+	// Compares the precomputed entrance distances with a search from each entrance to every cell of its cluster
+	bool EntranceDistancesMatchSearches()
+	{
+		for(auto l_ClusterIt = m_Nav.m_Clusters[1].begin(); l_ClusterIt != m_Nav.m_Clusters[1].end(); ++l_ClusterIt)
+		{
+			const unsigned l_NbCells = l_ClusterIt->BaseNodes.size();
+			for(unsigned i = 0; i < l_ClusterIt->Entrances.size(); ++i)
+			{
+				const Navigator::NodeId l_Entrance = m_Nav.BaseNode(l_ClusterIt->Entrances[i]);
+				for(unsigned l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
+				{
+					const Navigator::NodeId l_BaseNode = l_ClusterIt->BaseNodes[l_Cell];
+					double l_Distance = l_BaseNode == l_Entrance ? 0.0 
+						: m_Nav.AStar(l_Entrance, l_BaseNode, m_Nav.ClusterWindow(*l_ClusterIt), TrivialHeuristic());
+					if(std::abs(l_Distance - l_ClusterIt->EntranceDistances[i * l_NbCells + l_Cell]) > 1e-9 
+						&& l_Distance != l_ClusterIt->EntranceDistances[i * l_NbCells + l_Cell])
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Runs a search between the entrances of every cluster and returns the number of heap allocations they made
+	unsigned long long CountSearchAllocations()
+	{
+		Navigator::NodeVector l_Path;
+		l_Path.reserve(m_Nav.m_Nodes.Size());
+
+		unsigned long long l_NbAllocations = g_NbAllocations;
+		for(auto l_ClusterIt = m_Nav.m_Clusters[1].begin(); l_ClusterIt != m_Nav.m_Clusters[1].end(); ++l_ClusterIt)
+		{
+			for(auto l_It1 = l_ClusterIt->LevelNodes.begin(); l_It1 != l_ClusterIt->LevelNodes.end(); ++l_It1)
+			{
+				for(auto l_It2 = l_It1 + 1; l_It2 != l_ClusterIt->LevelNodes.end(); ++l_It2)
+				{
+					const Navigator::NodeId l_Start = m_Nav.BaseNode(*l_It1);
+					const Navigator::NodeId l_Goal = m_Nav.BaseNode(*l_It2);
+					if(m_Nav.AStar(l_Start, l_Goal, m_Nav.ClusterWindow(*l_ClusterIt), TrivialHeuristic()) < std::numeric_limits<double>::infinity())
+						m_Nav.ExtractPath(l_Goal, l_Path);
+				}
+			}
+		}
+		return g_NbAllocations - l_NbAllocations;
+	}
+
+	// Picks the same walkable positions on every run so that throughputs can be compared between builds
+	std::vector<Vector2> RandomWalkablePositions(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const unsigned in_NbPositions) const
+	{
+		std::default_random_engine l_Engine(42);
+		std::uniform_int_distribution<int> l_Distribution(0, in_Length * in_Width - 1);
+		std::vector<Vector2> l_Positions;
+
+		while(l_Positions.size() < in_NbPositions)
+		{
+			int l_Cell = l_Distribution(l_Engine);
+			if(!in_Level[l_Cell])
+				l_Positions.push_back(Vector2(static_cast<float>(l_Cell % in_Width), static_cast<float>(l_Cell / in_Width)));
+		}
+		return l_Positions;
+	}
+
+	// Writes a line per run in in_LogName when the performance is logged, its value between in_Label and in_Suffix
+#ifdef _LOG_PERF
+	static void LogRuns(const std::string & in_LogName, const std::string & in_Label, const std::vector<double> & in_Values, 
+		const std::string & in_Suffix = std::string())
+	{
+		std::ofstream l_FileStream(in_LogName, std::ios::out | std::ios::binary);
+		if(l_FileStream.is_open())
+		{
+			for(unsigned i = 0; i < in_Values.size(); ++i)
+			{
+				l_FileStream << "Run:" << i << in_Label << in_Values[i] << in_Suffix << std::endl;
+			}
+		}
+	}
+#else
+	static void LogRuns(const std::string &, const std::string &, const std::vector<double> &, const std::string & = std::string()) { }
+#endif
+
+	// Number of nodes expanded by the searches per millisecond spent in Init and in the path queries
+	double MeasureExpansionThroughput(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const std::string & in_LogName, const int in_MaxEntranceWidth = 3)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, 40));
+		std::vector<double> l_Throughputs;
+
+		for(int i = 0; i < 20; ++i)
+		{
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+
+			m_Nav.Init(in_Level, in_Length, in_Width, in_MaxEntranceWidth);
+			for(unsigned j = 0; j < l_Positions.size()-1; ++j)
+			{
+				Navigator::NodeVector l_AbstractPath(m_Nav.ComputeAbstractPath(l_Positions[j], l_Positions[j+1]));
+				for(unsigned k = 0; k + 1 < l_AbstractPath.size(); ++k)
+					m_Nav.ComputeConcretePath(l_AbstractPath[k], l_AbstractPath[k+1]);
+			}
+
+			boost::chrono::duration<double, boost::milli> l_Duration = boost::chrono::high_resolution_clock::now() - l_Start;
+			l_Throughputs.push_back(m_Nav.GetSearchStatistics().Expansions / l_Duration.count());
+			m_Nav.Reset();
+		}
+
+		LogRuns(in_LogName, " Expansions/ms: ", l_Throughputs);
+
+		return ComputeMean(l_Throughputs);
+	}
+
+	// Number of nodes and edges a query could leave behind in the abstract graphs
+	unsigned AbstractGraphSize() const
+	{
+		unsigned l_Size = m_Nav.m_Nodes.Size();
+		for(unsigned l_Level = 1; l_Level < m_Nav.m_Graphs.size(); ++l_Level)
+		{
+			l_Size += m_Nav.m_Graphs[l_Level].NbNodes() + m_Nav.m_Graphs[l_Level].NbEdges() + (m_Nav.m_Graphs[l_Level].HasOverlay() ? 1 : 0);
+			for(auto l_ClusterIt = m_Nav.m_Clusters[l_Level].begin(); l_ClusterIt != m_Nav.m_Clusters[l_Level].end(); ++l_ClusterIt)
+				l_Size += l_ClusterIt->LevelNodes.size() + l_ClusterIt->Entrances.size();
+		}
+		return l_Size;
+	}
+
+	// Issues batches of random abstract queries on an initialized Navigator. Returns false as soon as a batch
+	// changed the size of the abstract graph, the duration of each batch is written in out_BatchTimes.
+	bool QueriesKeepGraphFlat(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const unsigned in_NbBatches, const unsigned in_NbQueries, std::vector<double> & out_BatchTimes)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbBatches * in_NbQueries + 1));
+		const unsigned l_GraphSize = AbstractGraphSize();
+
+		for(unsigned i = 0; i < in_NbBatches; ++i)
+		{
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+			for(unsigned j = i * in_NbQueries; j < (i + 1) * in_NbQueries; ++j)
+				m_Nav.ComputeAbstractPath(l_Positions[j], l_Positions[j+1]);
+			out_BatchTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+
+			if(AbstractGraphSize() != l_GraphSize)
+				return false;
+		}
+		return true;
+	}
+
+	// Open level with a pillar every seven cells, the Navigator cuts it in as many clusters as it can
+	std::unique_ptr<float[]> MakePillarLevel(const int in_Length, const int in_Width) const
+	{
+		std::unique_ptr<float[]> l_Level(new float[in_Length * in_Width]);
+		for(int y = 0; y < in_Length; ++y)
+			for(int x = 0; x < in_Width; ++x)
+				l_Level[x + y * in_Width] = x % 7 == 3 && y % 7 == 3 ? 1.f : 0.f;
+		return l_Level;
+	}
+
+	// Mean time in milliseconds of an abstract query and of the concrete queries along its path once all of them are cached.
+	// Nothing is searched anymore so this is the cost of finding the clusters, the nodes and the cached paths.
+	double MeasureQueryOverhead(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const unsigned in_NbQueries, const std::string & in_LogName)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbQueries + 1));
+		std::vector<Vector2> l_Waypoints;
+		std::vector<double> l_Times;
+
+		for(int i = 0; i < 21; ++i)
+		{
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+			for(unsigned j = 0; j < in_NbQueries; ++j)
+			{
+				Navigator::NodeVector l_AbstractPath(m_Nav.ComputeAbstractPath(l_Positions[j], l_Positions[j+1]));
+				for(unsigned k = 0; k + 1 < l_AbstractPath.size(); ++k)
+					m_Nav.ComputeConcretePath(l_AbstractPath[k], l_AbstractPath[k+1], l_Waypoints);
+			}
+			boost::chrono::duration<double, boost::milli> l_Duration = boost::chrono::high_resolution_clock::now() - l_Start;
+
+			// The first run fills the caches
+			if(i)
+				l_Times.push_back(l_Duration.count() / in_NbQueries);
+		}
+
+		LogRuns(in_LogName, " Duration per query: ", l_Times);
+
+		return ComputeMean(l_Times);
+	}
+
+	// Rooms of 40x40 cells with a door of three cells in their east and south walls, the doors move from one room to the next
+	std::unique_ptr<float[]> MakeRoomsLevel(const int in_Length, const int in_Width) const
+	{
+		std::unique_ptr<float[]> l_Level(new float[in_Length * in_Width]);
+		for(int y = 0; y < in_Length; ++y)
+		{
+			for(int x = 0; x < in_Width; ++x)
+			{
+				const int l_EastDoor = (x / 40 * 7 + y / 40 * 13) % 35;
+				const int l_SouthDoor = (x / 40 * 11 + y / 40 * 5 + 17) % 35;
+				const bool l_EastWall = x % 40 == 39 && (y % 40 < l_EastDoor || y % 40 >= l_EastDoor + 3);
+				const bool l_SouthWall = y % 40 == 39 && (x % 40 < l_SouthDoor || x % 40 >= l_SouthDoor + 3);
+				l_Level[x + y * in_Width] = l_EastWall || l_SouthWall ? 1.f : 0.f;
+			}
+		}
+		return l_Level;
+	}
+
+	// Perfect maze whose corridors are two cells wide, dug by a depth first search from the top left corner
+	std::unique_ptr<float[]> MakeMazeLevel(const int in_Length, const int in_Width) const
+	{
+		std::unique_ptr<float[]> l_Level(new float[in_Length * in_Width]);
+		std::fill(l_Level.get(), l_Level.get() + in_Length * in_Width, 1.f);
+		const int l_NbColumns = in_Width / 3, l_NbRows = in_Length / 3;
+		const int l_DX[] = { 1, -1, 0, 0 }, l_DY[] = { 0, 0, 1, -1 };
+		std::vector<bool> l_Dug(l_NbColumns * l_NbRows, false);
+		std::vector<int> l_Stack(1, 0);
+		std::default_random_engine l_Engine(7);
+		l_Dug[0] = true;
+
+		while(!l_Stack.empty())
+		{
+			const int l_Room = l_Stack.back();
+			const int l_X = l_Room % l_NbColumns, l_Y = l_Room / l_NbColumns;
+			for(int y = 0; y < 2; ++y)
+				for(int x = 0; x < 2; ++x)
+					l_Level[(l_X * 3 + x) + (l_Y * 3 + y) * in_Width] = 0.f;
+
+			std::vector<int> l_Directions;
+			for(int d = 0; d < 4; ++d)
+			{
+				const int l_NextX = l_X + l_DX[d], l_NextY = l_Y + l_DY[d];
+				if(l_NextX >= 0 && l_NextX < l_NbColumns && l_NextY >= 0 && l_NextY < l_NbRows && !l_Dug[l_NextX + l_NextY * l_NbColumns])
+					l_Directions.push_back(d);
+			}
+			if(l_Directions.empty())
+			{
+				l_Stack.pop_back();
+				continue;
+			}
+
+			// The wall between the two rooms is opened on the two cells of the corridor
+			const int d = l_Directions[std::uniform_int_distribution<int>(0, static_cast<int>(l_Directions.size()) - 1)(l_Engine)];
+			for(int i = 0; i < 2; ++i)
+			{
+				const int l_WallX = l_DX[d] ? l_X * 3 + (l_DX[d] > 0 ? 2 : -1) : l_X * 3 + i;
+				const int l_WallY = l_DY[d] ? l_Y * 3 + (l_DY[d] > 0 ? 2 : -1) : l_Y * 3 + i;
+				l_Level[l_WallX + l_WallY * in_Width] = 0.f;
+			}
+			l_Dug[(l_X + l_DX[d]) + (l_Y + l_DY[d]) * l_NbColumns] = true;
+			l_Stack.push_back((l_X + l_DX[d]) + (l_Y + l_DY[d]) * l_NbColumns);
+		}
+		return l_Level;
+	}
+
+	// Searches between every pair of nodes of in_Queries on the graph with the given heuristic. The cost is the sum of the costs
+	// of the paths that were found and the duration is the mean duration of a search in milliseconds.
+	template<class GraphType, class HeuristicType>
+	HeuristicBenchmark BenchmarkHeuristic(const GraphType & in_Graph, const HeuristicType & in_Heuristic, 
+		const std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> & in_Queries)
+	{
+		HeuristicBenchmark l_Result = { 0.0, 0.0, m_Nav.GetSearchStatistics().Expansions };
+		boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+		for(auto l_It = in_Queries.begin(); l_It != in_Queries.end(); ++l_It)
+		{
+			const double l_Cost = m_Nav.AStar(l_It->first, l_It->second, in_Graph, in_Heuristic);
+			if(l_Cost < std::numeric_limits<double>::infinity())
+				l_Result.Cost += l_Cost;
+		}
+		l_Result.Duration = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count() / in_Queries.size();
+		l_Result.Expansions = m_Nav.GetSearchStatistics().Expansions - l_Result.Expansions;
+		return l_Result;
+	}
+
+	// Grid searches between random cells and abstract searches between random entrances of the first level with every heuristic,
+	// in the order trivial, Euclidean, Manhattan, landmarks, octile and the larger of octile and landmarks
+	void BenchmarkHeuristics(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const unsigned in_NbQueries,
+		std::vector<HeuristicBenchmark> & out_Grid, std::vector<HeuristicBenchmark> & out_Abstract)
+	{
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbQueries + 1));
+		std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> l_GridQueries, l_AbstractQueries;
+		Navigator::NodeVector l_Entrances;
+		for(auto l_It = m_Nav.m_Clusters[1].begin(); l_It != m_Nav.m_Clusters[1].end(); ++l_It)
+			l_Entrances.insert(l_Entrances.end(), l_It->Entrances.begin(), l_It->Entrances.end());
+
+		std::default_random_engine l_Engine(42);
+		std::uniform_int_distribution<unsigned> l_Distribution(0, static_cast<unsigned>(l_Entrances.size()) - 1);
+		for(unsigned i = 0; i < in_NbQueries; ++i)
+		{
+			l_GridQueries.push_back(std::make_pair(m_Nav.BaseNode(l_Positions[i]), m_Nav.BaseNode(l_Positions[i+1])));
+			l_AbstractQueries.push_back(std::make_pair(l_Entrances[l_Distribution(l_Engine)], l_Entrances[l_Distribution(l_Engine)]));
+		}
+
+		const GridGraph::Window l_Grid(m_Nav.m_Grid.Whole());
+		out_Grid.clear();
+		out_Grid.push_back(BenchmarkHeuristic(l_Grid, TrivialHeuristic(), l_GridQueries));
+		out_Grid.push_back(BenchmarkHeuristic(l_Grid, EuclideanDistance(), l_GridQueries));
+		out_Grid.push_back(BenchmarkHeuristic(l_Grid, ManhattanDistance(), l_GridQueries));
+		out_Grid.push_back(BenchmarkHeuristic(l_Grid, LandmarkDistance(m_Nav.m_Landmarks), l_GridQueries));
+		out_Grid.push_back(BenchmarkHeuristic(l_Grid, OctileDistance(), l_GridQueries));
+		out_Grid.push_back(BenchmarkHeuristic(l_Grid, MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Nav.m_Landmarks)), l_GridQueries));
+
+		out_Abstract.clear();
+		out_Abstract.push_back(BenchmarkHeuristic(m_Nav.m_Graphs[1], TrivialHeuristic(), l_AbstractQueries));
+		out_Abstract.push_back(BenchmarkHeuristic(m_Nav.m_Graphs[1], EuclideanDistance(), l_AbstractQueries));
+		out_Abstract.push_back(BenchmarkHeuristic(m_Nav.m_Graphs[1], ManhattanDistance(), l_AbstractQueries));
+		out_Abstract.push_back(BenchmarkHeuristic(m_Nav.m_Graphs[1], LandmarkDistance(m_Nav.m_Landmarks), l_AbstractQueries));
+		out_Abstract.push_back(BenchmarkHeuristic(m_Nav.m_Graphs[1], OctileDistance(), l_AbstractQueries));
+		out_Abstract.push_back(BenchmarkHeuristic(m_Nav.m_Graphs[1], MakeMaxHeuristic(OctileDistance(), LandmarkDistance(m_Nav.m_Landmarks)), l_AbstractQueries));
+		m_Nav.Reset();
+	}
+
+	// Calls the heuristic it wraps through a virtual function, the way the searches did before they took the heuristic
+	// as a template parameter
+	class VirtualHeuristic
+	{
+	public:
+		virtual ~VirtualHeuristic() { }
+		virtual double Estimate(const Vector2 & in_Start, const Vector2 & in_Goal) const = 0;
+
+		double operator()(const Vector2 & in_Start, const Vector2 & in_Goal) const
+		{
+			return Estimate(in_Start, in_Goal);
+		}
+	};
+
+	template<class HeuristicType>
+	class VirtualPolicy : public VirtualHeuristic
+	{
+	private:
+		HeuristicType m_Heuristic;
+
+	public:
+		explicit VirtualPolicy(const HeuristicType & in_Heuristic) : m_Heuristic(in_Heuristic) { }
+
+		double Estimate(const Vector2 & in_Start, const Vector2 & in_Goal) const
+		{
+			return m_Heuristic(in_Start, in_Goal);
+		}
+	};
+
+	// Grid searches between random cells with the octile distance and the larger of octile and landmarks, each heuristic
+	// inlined in the search then called through a virtual function, in that order
+	void BenchmarkHeuristicDispatch(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const unsigned in_NbQueries,
+		std::vector<HeuristicBenchmark> & out_Results)
+	{
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbQueries + 1));
+		std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> l_Queries;
+		for(unsigned i = 0; i < in_NbQueries; ++i)
+			l_Queries.push_back(std::make_pair(m_Nav.BaseNode(l_Positions[i]), m_Nav.BaseNode(l_Positions[i+1])));
+
+		const GridGraph::Window l_Grid(m_Nav.m_Grid.Whole());
+		const OctileDistance l_Octile;
+		const MaxHeuristic<OctileDistance, LandmarkDistance> l_OctileLandmarks(l_Octile, LandmarkDistance(m_Nav.m_Landmarks));
+		std::unique_ptr<VirtualHeuristic> l_VirtualOctile(new VirtualPolicy<OctileDistance>(l_Octile));
+		std::unique_ptr<VirtualHeuristic> l_VirtualOctileLandmarks(new VirtualPolicy<MaxHeuristic<OctileDistance, LandmarkDistance>>(l_OctileLandmarks));
+
+		out_Results.clear();
+		out_Results.push_back(BenchmarkHeuristic(l_Grid, l_Octile, l_Queries));
+		out_Results.push_back(BenchmarkHeuristic(l_Grid, *l_VirtualOctile, l_Queries));
+		out_Results.push_back(BenchmarkHeuristic(l_Grid, l_OctileLandmarks, l_Queries));
+		out_Results.push_back(BenchmarkHeuristic(l_Grid, *l_VirtualOctileLandmarks, l_Queries));
+		m_Nav.Reset();
+	}
+
+	// Cost of an abstract path once it is refined in concrete paths. Consecutive nodes are either in the same cluster of the
+	// first level or on both sides of a gate, a negative cost is returned otherwise.
+	double RefinedPathCost(const Navigator::NodeVector & in_Path)
+	{
+		std::vector<Vector2> l_Path;
+		double l_Cost = 0.0;
+		for(unsigned i = 0; i + 1 < in_Path.size(); ++i)
+		{
+			m_Nav.ComputeConcretePath(in_Path[i], in_Path[i+1], l_Path);
+			if(!l_Path.empty())
+			{
+				l_Cost += ConcretePathCost(l_Path);
+				continue;
+			}
+
+			const Vector2 l_Step = m_Nav.GetPosition(in_Path[i+1]) - m_Nav.GetPosition(in_Path[i]);
+			if(std::abs(l_Step.x) + std::abs(l_Step.y) != 1.f)
+				return -1.0;
+			l_Cost += 1.0;
+		}
+		return l_Cost;
+	}
+
+	// Total cost of the abstract paths between random positions with at most the given number of abstract levels, 0 lets
+	// the Navigator pick it. The number of levels that were built and the mean time of a query in milliseconds are written
+	// in out_Depth and out_Time.
+	double MeasureAbstractPaths(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const int in_MaxDepth,
+		const unsigned in_NbQueries, int & out_Depth, double & out_Time)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbQueries + 1));
+		std::vector<Navigator::NodeVector> l_Paths;
+
+		m_Nav.SetMaxDepth(in_MaxDepth);
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		out_Depth = m_Nav.GetDepth();
+
+		boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+		for(unsigned i = 0; i < in_NbQueries; ++i)
+			l_Paths.push_back(m_Nav.ComputeAbstractPath(l_Positions[i], l_Positions[i+1]));
+		out_Time = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count() / in_NbQueries;
+
+		double l_Cost = 0.0;
+		for(auto l_It = l_Paths.begin(); l_It != l_Paths.end(); ++l_It)
+		{
+			const double l_PathCost = RefinedPathCost(*l_It);
+			if(l_It->empty() || l_PathCost < 0.0)
+				return -1.0;
+			l_Cost += l_PathCost;
+		}
+		m_Nav.Reset();
+		return l_Cost;
+	}
+
+	// Runs every query in_NbRuns times with the given search on the top level, without the abstract path cache. The costs of
+	// the refined paths are written in out_Costs, the expansions of a run in out_Expansions and the mean duration of a query
+	// in milliseconds in out_Time.
+	void BenchmarkAbstractSearch(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const int in_MaxDepth,
+		const std::vector<std::pair<Vector2, Vector2>> & in_Queries, const Navigator::AbstractSearch in_Search, const unsigned in_NbRuns,
+		std::vector<double> & out_Costs, unsigned long long & out_Expansions, double & out_Time)
+	{
+		m_Nav.SetMaxDepth(in_MaxDepth);
+		m_Nav.SetAbstractSearch(in_Search);
+		m_Nav.SetPathCacheBudgets(Navigator::M_CONCRETECACHEBUDGET, 0);
+		m_Nav.Init(in_Level, in_Length, in_Width);
+
+		out_Costs.clear();
+		for(auto l_It = in_Queries.begin(); l_It != in_Queries.end(); ++l_It)
+			out_Costs.push_back(RefinedPathCost(m_Nav.ComputeAbstractPath(l_It->first, l_It->second)));
+
+		out_Expansions = m_Nav.GetSearchStatistics().Expansions;
+		boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+		for(unsigned i = 0; i < in_NbRuns; ++i)
+			for(auto l_It = in_Queries.begin(); l_It != in_Queries.end(); ++l_It)
+				m_Nav.ComputeAbstractPath(l_It->first, l_It->second);
+		out_Time = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count() 
+			/ (in_NbRuns * in_Queries.size());
+		out_Expansions = (m_Nav.GetSearchStatistics().Expansions - out_Expansions) / in_NbRuns;
+
+		m_Nav.Reset();
+		m_Nav.SetMaxDepth(0);
+		m_Nav.SetAbstractSearch(Navigator::ForwardSearch);
+		m_Nav.SetPathCacheBudgets(Navigator::M_CONCRETECACHEBUDGET, Navigator::M_ABSTRACTCACHEBUDGET);
+	}
+
+	// Everything the preprocessing builds, flattened in the order it was built
+	std::vector<double> PreprocessingResult() const
+	{
+		std::vector<double> l_Result;
+		l_Result.push_back(m_Nav.m_Nodes.Size());
+		l_Result.push_back(static_cast<double>(m_Nav.GetSearchStatistics().Searches));
+		l_Result.push_back(static_cast<double>(m_Nav.GetSearchStatistics().Expansions));
+		for(unsigned l_Level = 1; l_Level < m_Nav.m_Graphs.size(); ++l_Level)
+		{
+			const CompactGraph & l_Graph = m_Nav.m_Graphs[l_Level];
+			for(unsigned l_Node = 0; l_Node < l_Graph.NbNodes(); ++l_Node)
+			{
+				l_Result.push_back(l_Graph.End(l_Node) - l_Graph.Begin(l_Node));
+				for(unsigned l_Edge = l_Graph.Begin(l_Node); l_Edge != l_Graph.End(l_Node); ++l_Edge)
+				{
+					l_Result.push_back(l_Graph.Target(l_Edge));
+					l_Result.push_back(l_Graph.Cost(l_Edge));
+				}
+			}
+
+			for(auto l_ClusterIt = m_Nav.m_Clusters[l_Level].begin(); l_ClusterIt != m_Nav.m_Clusters[l_Level].end(); ++l_ClusterIt)
+			{
+				l_Result.insert(l_Result.end(), l_ClusterIt->Entrances.begin(), l_ClusterIt->Entrances.end());
+				l_Result.insert(l_Result.end(), l_ClusterIt->EntranceDistances.begin(), l_ClusterIt->EntranceDistances.end());
+				for(auto l_PathIt = l_ClusterIt->EntrancePaths.begin(); l_PathIt != l_ClusterIt->EntrancePaths.end(); ++l_PathIt)
+					l_Result.insert(l_Result.end(), l_PathIt->begin(), l_PathIt->end());
+			}
+		}
+		return l_Result;
+	}
+
+	// Mean duration in milliseconds of Init with the given number of workers, the preprocessing result is written in out_Result
+	double MeasureInit(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const unsigned in_NbWorkers,
+		std::vector<double> & out_Result)
+	{
+		std::vector<double> l_Times;
+		m_Nav.SetWorkerCount(in_NbWorkers);
+		for(int i = 0; i < 21; ++i)
+		{
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+			m_Nav.Init(in_Level, in_Length, in_Width);
+			l_Times.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+			if(i == 0)
+				out_Result = PreprocessingResult();
+			m_Nav.Reset();
+		}
+		return ComputeMean(l_Times);
+	}
+
+	// Concrete queries between the consecutive nodes of the abstract paths linking random positions
+	std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> ConcreteQueries(const std::unique_ptr<float[]> & in_Level, 
+		const int in_Length, const int in_Width, const unsigned in_NbPositions)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbPositions));
+		std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> l_Queries;
+
+		for(unsigned i = 0; i + 1 < l_Positions.size(); ++i)
+		{
+			Navigator::NodeVector l_AbstractPath(m_Nav.ComputeAbstractPath(l_Positions[i], l_Positions[i+1]));
+			for(unsigned j = 0; j + 1 < l_AbstractPath.size(); ++j)
+				l_Queries.push_back(std::make_pair(l_AbstractPath[j], l_AbstractPath[j+1]));
+		}
+		return l_Queries;
+	}
+
+	static double ConcretePathCost(const std::vector<Vector2> & in_Path)
+	{
+		double l_Cost = 0.0;
+		for(unsigned i = 0; i + 1 < in_Path.size(); ++i)
+			l_Cost += in_Path[i].x != in_Path[i+1].x && in_Path[i].y != in_Path[i+1].y ? 1.42 : 1.0;
+		return l_Cost;
+	}
+
+	// Runs the concrete queries with the given cluster search. The concrete cache is disabled so that every query is searched.
+	// Returns the mean time of a run in milliseconds. The costs of the paths are written in out_Costs
+	// and the number of nodes expanded by a run in out_Expansions.
+	double RunClusterSearches(const std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> & in_Queries, 
+		const Navigator::ClusterSearch in_Search, std::vector<double> & out_Costs, unsigned long long & out_Expansions, 
+		const std::string & in_LogName)
+	{
+		std::vector<Vector2> l_Path;
+		std::vector<double> l_Times;
+
+		m_Nav.SetPathCacheBudgets(0, 1024 * 1024);
+		m_Nav.SetClusterSearch(in_Search);
+		for(int i = 0; i < 20; ++i)
+		{
+			const unsigned long long l_Expansions = m_Nav.GetSearchStatistics().Expansions;
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+			for(unsigned j = 0; j < in_Queries.size(); ++j)
+			{
+				m_Nav.ComputeConcretePath(in_Queries[j].first, in_Queries[j].second, l_Path);
+				if(!i)
+					out_Costs.push_back(ConcretePathCost(l_Path));
+			}
+			l_Times.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+			out_Expansions = m_Nav.GetSearchStatistics().Expansions - l_Expansions;
+		}
+
+		LogRuns(in_LogName, " Duration: ", l_Times, " Expansions: " + std::to_string(out_Expansions));
+
+		return ComputeMean(l_Times);
+	}
+
+	// Jump point search must find paths as short as the ones of the grid A* while expanding fewer nodes
+	bool JumpPointSearchMatchesGridAStar(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
+		const std::string & in_LogName, const int in_MaxEntranceWidth = 3)
+	{
+		m_Nav.Init(in_Level, in_Length, in_Width, in_MaxEntranceWidth);
+		std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> l_Queries(ConcreteQueries(in_Level, in_Length, in_Width, 100));
+
+		std::vector<double> l_GridCosts, l_JumpCosts;
+		unsigned long long l_GridExpansions = 0, l_JumpExpansions = 0;
+		RunClusterSearches(l_Queries, Navigator::GridAStar, l_GridCosts, l_GridExpansions, "Grid A* " + in_LogName);
+		RunClusterSearches(l_Queries, Navigator::JumpPointSearch, l_JumpCosts, l_JumpExpansions, "Jump Point Search " + in_LogName);
+		m_Nav.Reset();
+
+		for(unsigned i = 0; i < l_GridCosts.size(); ++i)
+			if(std::abs(l_GridCosts[i] - l_JumpCosts[i]) > 1e-6)
+				return false;
+		return !l_Queries.empty() && l_JumpExpansions < l_GridExpansions;
+	}
+
+	// The concrete paths must stay as short as the searched ones while the background worker publishes the clusters
+	// and after it is done, at which point the queries do not search anymore
+	bool ClusterProcessingMatchesSearches(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
+		const std::string & in_LogName)
+	{
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		std::vector<std::pair<Navigator::NodeId, Navigator::NodeId>> l_Queries(ConcreteQueries(in_Level, in_Length, in_Width, 100));
+
+		std::vector<double> l_SearchCosts, l_PublishedCosts;
+		unsigned long long l_SearchExpansions = 0, l_PublishedExpansions = 0;
+		RunClusterSearches(l_Queries, Navigator::GridAStar, l_SearchCosts, l_SearchExpansions, "Searched " + in_LogName);
+
+		m_Nav.StartClusterProcessing();
+		std::vector<Vector2> l_Path;
+		for(unsigned i = 0; i < l_Queries.size(); ++i)
+		{
+			m_Nav.ComputeConcretePath(l_Queries[i].first, l_Queries[i].second, l_Path);
+			if(std::abs(ConcretePathCost(l_Path) - l_SearchCosts[i]) > 1e-6 
+				|| (!l_Path.empty() && !(l_Path.front() == m_Nav.GetPosition(l_Queries[i].first) && l_Path.back() == m_Nav.GetPosition(l_Queries[i].second))))
+				return false;
+		}
+		m_Nav.WaitClusterProcessing();
+		const bool l_AllProcessed = m_Nav.GetNbProcessedClusters() == m_Nav.m_Clusters[1].size();
+
+		RunClusterSearches(l_Queries, Navigator::GridAStar, l_PublishedCosts, l_PublishedExpansions, "Published " + in_LogName);
+		m_Nav.Reset();
+
+		for(unsigned i = 0; i < l_SearchCosts.size(); ++i)
+			if(std::abs(l_SearchCosts[i] - l_PublishedCosts[i]) > 1e-6)
+				return false;
+		return !l_Queries.empty() && l_AllProcessed && l_PublishedExpansions == 0;
+	}
+
+	// Records the cost and the parent of every cell of a cluster for a search from each of its cells
+	struct ClusterSearchRecorder
+	{
+		const Navigator * Nav;
+		const Navigator::Cluster * Area;
+		std::vector<double> * Costs;
+		std::vector<unsigned> * Parents;
+
+		template<class SearchType>
+		void operator()(SearchType & io_Search) const
+		{
+			const unsigned l_NbCells = Area->Length * Area->Width;
+			io_Search.Load(Nav->m_Grid, static_cast<int>(Area->MinPos.x), static_cast<int>(Area->MinPos.y), Area->Length, Area->Width);
+			for(unsigned l_Source = 0; l_Source < l_NbCells; ++l_Source)
+			{
+				const bool l_Searched = io_Search.Run(l_Source);
+				for(unsigned l_Cell = 0; l_Cell < l_NbCells; ++l_Cell)
+				{
+					const bool l_Reached = l_Searched && io_Search.Reached(l_Cell);
+					Costs->push_back(l_Reached ? io_Search.Cost(l_Cell) : std::numeric_limits<double>::infinity());
+					Parents->push_back(l_Reached ? io_Search.Parent(l_Cell) : FixedClusterSearch<8, true>::M_NOPARENT);
+				}
+			}
+		}
+	};
+
+	// Searches from every cell of every cluster of the first level with the generic Dijkstra on the grid, then with the
+	// searches specialised on the size of the clusters. Both must find the same costs and the same parents. The durations
+	// of all the searches in milliseconds are returned in out_GenericTime and out_SpecialisedTime.
+	bool ClusterSearchMatchesDijkstra(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
+		double & out_GenericTime, double & out_SpecialisedTime)
+	{
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		std::vector<double> l_GenericCosts, l_SpecialisedCosts;
+		std::vector<unsigned> l_GenericParents, l_SpecialisedParents;
+		Navigator::SearchStatistics l_Statistics;
+
+		boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+		for(auto l_ClusterIt = m_Nav.m_Clusters[1].begin(); l_ClusterIt != m_Nav.m_Clusters[1].end(); ++l_ClusterIt)
+		{
+			const Navigator::NodeVector & l_Cells = l_ClusterIt->BaseNodes;
+			for(auto l_SourceIt = l_Cells.begin(); l_SourceIt != l_Cells.end(); ++l_SourceIt)
+			{
+				const bool l_Searched = m_Nav.Dijkstra(*l_SourceIt, m_Nav.ClusterWindow(*l_ClusterIt), m_Nav.m_SearchContext, l_Statistics);
+				for(auto l_CellIt = l_Cells.begin(); l_CellIt != l_Cells.end(); ++l_CellIt)
+				{
+					const bool l_Reached = l_Searched && m_Nav.m_SearchContext.Closed(*l_CellIt);
+					const Navigator::NodeId l_Parent = m_Nav.m_SearchContext.Parent(*l_CellIt);
+					l_GenericCosts.push_back(l_Reached ? m_Nav.m_SearchContext.Cost(*l_CellIt) : std::numeric_limits<double>::infinity());
+					l_GenericParents.push_back(l_Reached && l_Parent != SearchContext::M_NOPARENT 
+						? m_Nav.CellInCluster(*l_ClusterIt, l_Parent) : FixedClusterSearch<8, true>::M_NOPARENT);
+				}
+			}
+		}
+		out_GenericTime = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count();
+
+		l_Start = boost::chrono::high_resolution_clock::now();
+		for(auto l_ClusterIt = m_Nav.m_Clusters[1].begin(); l_ClusterIt != m_Nav.m_Clusters[1].end(); ++l_ClusterIt)
+		{
+			ClusterSearchRecorder l_Recorder = { &m_Nav, &*l_ClusterIt, &l_SpecialisedCosts, &l_SpecialisedParents };
+			m_Nav.WithFixedSearch(*l_ClusterIt, l_Recorder);
+		}
+		out_SpecialisedTime = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count();
+		m_Nav.Reset();
+
+		return !l_GenericCosts.empty() && l_GenericCosts == l_SpecialisedCosts && l_GenericParents == l_SpecialisedParents;
+	}
+
+	// Without diagonals, the distances in an empty cluster are the Manhattan distances
+	static bool FourConnectedSearchIsManhattan()
+	{
+		const int l_Size = 6;
+		std::unique_ptr<float[]> l_Level(new float[l_Size * l_Size]);
+		std::fill(l_Level.get(), l_Level.get() + l_Size * l_Size, 0.f);
+		GridGraph l_Grid;
+		l_Grid.Build(l_Level, l_Size, l_Size);
+
+		FixedClusterSearch<8, false> l_Search;
+		l_Search.Load(l_Grid, 0, 0, l_Size, l_Size);
+		for(int l_Source = 0; l_Source < l_Size * l_Size; ++l_Source)
+		{
+			if(!l_Search.Run(l_Source))
+				return false;
+			for(int l_Cell = 0; l_Cell < l_Size * l_Size; ++l_Cell)
+				if(l_Search.Cost(l_Cell) != std::abs(l_Cell % l_Size - l_Source % l_Size) + std::abs(l_Cell / l_Size - l_Source / l_Size))
+					return false;
+		}
+		return true;
+	}
+
+	// Issues abstract queries right after the Navigator started building the hierarchy in the background. Every query must
+	// get a path, the ones issued before the hierarchy is ready are counted in out_NbFlatQueries. The paths found on the
+	// flat grid must still be followed once the hierarchy is ready. The durations in milliseconds of Init and of
+	// InitInBackground are written in out_InitTime and out_BackgroundInitTime.
+	bool FlatPathsUntilHierarchyReady(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const unsigned in_NbQueries, unsigned & out_NbFlatQueries, double & out_InitTime, double & out_BackgroundInitTime)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbQueries + 1));
+		std::vector<Navigator::NodeVector> l_FlatPaths;
+
+		boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		out_InitTime = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count();
+		m_Nav.Reset();
+
+		l_Start = boost::chrono::high_resolution_clock::now();
+		m_Nav.InitInBackground(in_Level, in_Length, in_Width);
+		out_BackgroundInitTime = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count();
+
+		out_NbFlatQueries = 0;
+		for(unsigned i = 0; i < in_NbQueries; ++i)
+		{
+			const bool l_Flat = !m_Nav.IsHierarchyReady();
+			Navigator::NodeVector l_Path(m_Nav.ComputeAbstractPath(l_Positions[i], l_Positions[i+1]));
+			if(l_Path.empty() || RefinedPathCost(l_Path) < 0.0)
+				return false;
+
+			if(l_Flat)
+			{
+				++out_NbFlatQueries;
+				l_FlatPaths.push_back(l_Path);
+			}
+		}
+
+		m_Nav.WaitClusterProcessing();
+		for(auto l_It = l_FlatPaths.begin(); l_It != l_FlatPaths.end(); ++l_It)
+			if(RefinedPathCost(*l_It) < 0.0)
+				return false;
+
+		const bool l_Ready = m_Nav.IsHierarchyReady() && m_Nav.GetDepth() >= 1;
+		const bool l_FlatSearches = m_Nav.GetFlatSearchStatistics().Searches > 0 || !out_NbFlatQueries;
+		m_Nav.Reset();
+		return l_Ready && l_FlatSearches;
+	}
+
+	// Resets the Navigator at several moments of the background preprocessing run by in_NbWorkers workers, from right after
+	// InitInBackground to once the paths of the clusters are being built. The Navigator must still build the level afterwards.
+	bool ResetDuringBackgroundInit(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const unsigned in_NbWorkers)
+	{
+		const int l_Delays[] = { 0, 1, 5, 20, 100 };
+		const std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, 2));
+		m_Nav.SetWorkerCount(in_NbWorkers);
+		for(unsigned i = 0; i < sizeof(l_Delays) / sizeof(l_Delays[0]); ++i)
+		{
+			m_Nav.InitInBackground(in_Level, in_Length, in_Width);
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(l_Delays[i]));
+			m_Nav.Reset();
+		}
+
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		const bool l_Success = m_Nav.GetDepth() >= 1 && !m_Nav.ComputeAbstractPath(l_Positions[0], l_Positions[1]).empty();
+		m_Nav.Reset();
+		m_Nav.SetWorkerCount(0);
+		return l_Success;
+	}
+
+	// The distance between random positions must be between the length of the shortest path and the length of the path of the hierarchy.
+	// The mean durations of a distance query and of an abstract path query are written in milliseconds.
+	bool DistancesMatchPaths(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, const unsigned in_NbPositions,
+		double & out_DistanceTime, double & out_PathTime)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbPositions));
+		std::vector<double> l_DistanceTimes, l_PathTimes;
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		bool l_Success = m_Nav.HasDistanceTable();
+
+		for(unsigned i = 0; l_Success && i + 1 < l_Positions.size(); ++i)
+		{
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+			const double l_Distance = m_Nav.GetDistance(l_Positions[i], l_Positions[i+1]);
+			l_DistanceTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+
+			l_Start = boost::chrono::high_resolution_clock::now();
+			Navigator::NodeVector l_Path(m_Nav.ComputeAbstractPath(l_Positions[i], l_Positions[i+1]));
+			l_PathTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+
+			const double l_ShortestDistance = m_Nav.SearchFlat(m_Nav.BaseNode(l_Positions[i]), m_Nav.BaseNode(l_Positions[i+1]));
+			if(l_Path.empty())
+			{
+				l_Success = l_Distance == std::numeric_limits<double>::infinity() && l_ShortestDistance == l_Distance;
+				continue;
+			}
+			// The table holds floats
+			l_Success = l_Distance > l_ShortestDistance - 1e-3 && l_Distance < RefinedPathCost(l_Path) + 1e-3;
+		}
+
+		m_Nav.Reset();
+		out_DistanceTime = ComputeMean(l_DistanceTimes);
+		out_PathTime = ComputeMean(l_PathTimes);
+		return l_Success;
+	}
+
+	// Walls the border of a square of in_Size cells whose top left corner is given, its inside becomes a pocket
+	void AddWalledBox(std::unique_ptr<float[]> & io_Level, const int in_Width, const int in_MinX, const int in_MinY, const int in_Size) const
+	{
+		for(int i = 0; i < in_Size; ++i)
+		{
+			io_Level[in_MinX + i + in_MinY * in_Width] = 1.f;
+			io_Level[in_MinX + i + (in_MinY + in_Size - 1) * in_Width] = 1.f;
+			io_Level[in_MinX + (in_MinY + i) * in_Width] = 1.f;
+			io_Level[in_MinX + in_Size - 1 + (in_MinY + i) * in_Width] = 1.f;
+		}
+	}
+
+	// Every pair of entrances of an upper cluster linked by its searches must be an edge of the graph of its level, with the
+	// cost the searches found. The number of such pairs is written in out_NbPairs.
+	bool UpperEdgesMatchEntranceDistances(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const int in_MaxDepth, unsigned & out_NbPairs)
+	{
+		m_Nav.SetMaxDepth(in_MaxDepth);
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		bool l_Success = m_Nav.GetDepth() >= 2;
+		out_NbPairs = 0;
+
+		for(unsigned l_Level = 2; l_Success && l_Level < m_Nav.m_Graphs.size(); ++l_Level)
+		{
+			const CompactGraph & l_Graph = m_Nav.m_Graphs[l_Level];
+			for(auto l_It = m_Nav.m_Clusters[l_Level].begin(); l_Success && l_It != m_Nav.m_Clusters[l_Level].end(); ++l_It)
+			{
+				const Navigator::NodeVector & l_Entrances = l_It->Entrances;
+				for(unsigned i = 0; l_Success && i < l_Entrances.size(); ++i)
+				{
+					for(unsigned j = 0; l_Success && j < l_Entrances.size(); ++j)
+					{
+						const double l_Distance = l_It->EntranceDistances[i * l_Entrances.size() + j];
+						if(i == j || l_Distance == std::numeric_limits<double>::infinity())
+							continue;
+
+						unsigned l_Edge = l_Graph.Begin(l_Entrances[i]);
+						while(l_Edge != l_Graph.End(l_Entrances[i]) && l_Graph.Target(l_Edge) != l_Entrances[j])
+							++l_Edge;
+						l_Success = l_Edge != l_Graph.End(l_Entrances[i]) && std::abs(l_Graph.Cost(l_Edge) - l_Distance) < 1e-6;
+						++out_NbPairs;
+					}
+				}
+			}
+		}
+
+		m_Nav.Reset();
+		m_Nav.SetMaxDepth(0);
+		return l_Success;
+	}
+
+	// Reachable must tell whether the flat search finds a path between random positions and the given ones. The unreachable
+	// queries must be rejected without expanding any node. The mean durations in milliseconds of a rejected abstract path query
+	// and of the search that exhausts the grid without the components are written in out_RejectTime and out_SearchTime.
+	bool ReachabilityMatchesSearches(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const std::vector<Vector2> & in_Positions, const unsigned in_NbPositions, double & out_RejectTime, double & out_SearchTime)
+	{
+		std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbPositions));
+		l_Positions.insert(l_Positions.end(), in_Positions.begin(), in_Positions.end());
+		std::vector<double> l_RejectTimes, l_SearchTimes;
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		bool l_Success = true;
+
+		for(unsigned i = 0; l_Success && i < l_Positions.size(); ++i)
+		{
+			const Vector2 & l_Start = l_Positions[i];
+			const Vector2 & l_Goal = l_Positions[(i * 7 + 3) % l_Positions.size()];
+			const bool l_Reachable = m_Nav.Reachable(l_Start, l_Goal);
+			l_Success = l_Reachable == (m_Nav.SearchFlat(m_Nav.BaseNode(l_Start), m_Nav.BaseNode(l_Goal)) < std::numeric_limits<double>::infinity());
+			if(l_Reachable)
+				continue;
+
+			const unsigned long long l_Expansions = m_Nav.GetSearchStatistics().Expansions;
+			boost::chrono::high_resolution_clock::time_point l_Begin = boost::chrono::high_resolution_clock::now();
+			const bool l_Rejected = m_Nav.ComputeAbstractPath(l_Start, l_Goal).empty();
+			l_RejectTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Begin).count());
+			l_Success = l_Rejected && m_Nav.GetSearchStatistics().Expansions == l_Expansions
+				&& m_Nav.GetDistance(l_Start, l_Goal) == std::numeric_limits<double>::infinity();
+
+			l_Begin = boost::chrono::high_resolution_clock::now();
+			m_Nav.AStar(m_Nav.BaseNode(l_Start), m_Nav.BaseNode(l_Goal), GridGraph::JumpWindow(m_Nav.m_Grid.Whole(), m_Nav.BaseNode(l_Goal)), 
+				OctileDistance(), m_Nav.m_FlatContext, m_Nav.m_FlatStatistics);
+			l_SearchTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Begin).count());
+		}
+
+		m_Nav.Reset();
+		// The means leave out the 5 fastest and the 5 slowest queries
+		if(!l_Success || l_RejectTimes.size() <= 10)
+			return false;
+		out_RejectTime = ComputeMean(l_RejectTimes);
+		out_SearchTime = ComputeMean(l_SearchTimes);
+		return true;
+	}
+
+	// The flow paths from random positions to the goals must be as short as the paths of the flat search, with the distances
+	// and the first steps of their fields. The goals that cannot be reached must give no path. The mean durations in milliseconds
+	// of a flow path and of a refined abstract path to a goal are written in out_FlowTime and out_PathTime.
+	bool FlowPathsMatchSearches(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const std::vector<Vector2> & in_Goals, const unsigned in_NbPositions, double & out_FlowTime, double & out_PathTime)
+	{
+		const std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, in_NbPositions));
+		std::vector<double> l_FlowTimes, l_PathTimes;
+		std::vector<Vector2> l_Path;
+		for(auto l_It = in_Goals.begin(); l_It != in_Goals.end(); ++l_It)
+			m_Nav.AddFlowGoal(*l_It);
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		bool l_Success = true;
+
+		for(unsigned i = 0; l_Success && i < l_Positions.size(); ++i)
+		{
+			for(unsigned l_Goal = 0; l_Success && l_Goal < in_Goals.size(); ++l_Goal)
+			{
+				l_Path.clear();
+				boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+				const bool l_Found = m_Nav.GetFlowPath(l_Goal, l_Positions[i], l_Path);
+				l_FlowTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+
+				const double l_Cost = m_Nav.SearchFlat(m_Nav.BaseNode(l_Positions[i]), m_Nav.BaseNode(in_Goals[l_Goal]));
+				if(l_Cost == std::numeric_limits<double>::infinity())
+				{
+					l_Success = !l_Found && m_Nav.GetFlowDistance(l_Goal, l_Positions[i]) == l_Cost;
+					continue;
+				}
+
+				Vector2 l_Waypoint;
+				l_Success = l_Found && l_Path.front() == l_Positions[i] && l_Path.back() == in_Goals[l_Goal]
+					&& std::abs(ConcretePathCost(l_Path) - l_Cost) < 1e-3 && std::abs(m_Nav.GetFlowDistance(l_Goal, l_Positions[i]) - l_Cost) < 1e-3
+					&& m_Nav.GetFlowWaypoint(l_Goal, l_Positions[i], l_Waypoint) && l_Waypoint == l_Path[std::min<std::size_t>(1, l_Path.size() - 1)];
+				for(unsigned j = 0; l_Success && j + 1 < l_Path.size(); ++j)
+					l_Success = std::abs(l_Path[j].x - l_Path[j+1].x) <= 1.f && std::abs(l_Path[j].y - l_Path[j+1].y) <= 1.f
+						&& !in_Level[static_cast<int>(l_Path[j+1].x) + static_cast<int>(l_Path[j+1].y) * in_Width];
+
+				l_Start = boost::chrono::high_resolution_clock::now();
+				RefinedPathCost(m_Nav.ComputeAbstractPath(l_Positions[i], in_Goals[l_Goal]));
+				l_PathTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+			}
+		}
+
+		m_Nav.Reset();
+		m_Nav.ClearFlowGoals();
+		out_FlowTime = ComputeMean(l_FlowTimes);
+		out_PathTime = ComputeMean(l_PathTimes);
+		return l_Success;
+	}
+
+	// Number of moves from the source to every cell with a breadth first search on a queue, the reference of the wavefronts
+	static std::vector<unsigned short> StepDistances(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const Vector2 & in_Source)
+	{
+		std::vector<unsigned short> l_Steps(in_Length * in_Width, static_cast<unsigned short>(Wavefront::M_UNREACHED));
+		std::queue<int> l_Queue;
+		l_Queue.push(static_cast<int>(in_Source.x) + static_cast<int>(in_Source.y) * in_Width);
+		l_Steps[l_Queue.front()] = 0;
+		while(!l_Queue.empty())
+		{
+			const int l_Cell = l_Queue.front();
+			l_Queue.pop();
+			for(int l_Y = std::max(l_Cell / in_Width - 1, 0); l_Y <= std::min(l_Cell / in_Width + 1, in_Length - 1); ++l_Y)
+			{
+				for(int l_X = std::max(l_Cell % in_Width - 1, 0); l_X <= std::min(l_Cell % in_Width + 1, in_Width - 1); ++l_X)
+				{
+					const int l_Neighbor = l_X + l_Y * in_Width;
+					if(in_Level[l_Neighbor] || l_Steps[l_Neighbor] != Wavefront::M_UNREACHED)
+						continue;
+					l_Steps[l_Neighbor] = l_Steps[l_Cell] + 1;
+					l_Queue.push(l_Neighbor);
+				}
+			}
+		}
+		return l_Steps;
+	}
+
+	// Both wavefront kernels must give the layers of the breadth first searches, and reach the cells the searches on the grid
+	// reach. The mean durations in milliseconds of the layers of all the sources with each kernel and of one search from each
+	// source over the whole grid are written in out_ScalarTime, out_SimdTime and out_SearchTime.
+	bool BenchmarkWavefront(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const std::vector<Vector2> & in_Sources, const unsigned in_NbRuns, double & out_ScalarTime, double & out_SimdTime, double & out_SearchTime)
+	{
+		std::vector<double> l_ScalarTimes, l_SimdTimes, l_SearchTimes;
+		std::vector<std::vector<unsigned short>> l_ScalarLayers, l_SimdLayers;
+		m_Nav.Init(in_Level, in_Length, in_Width);
+
+		for(unsigned i = 0; i < in_NbRuns; ++i)
+		{
+			m_Nav.SetWavefrontKernel(Navigator::ScalarWavefront);
+			boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+			m_Nav.ComputeDistanceLayers(in_Sources, l_ScalarLayers);
+			l_ScalarTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+
+			m_Nav.SetWavefrontKernel(Navigator::SimdWavefront);
+			l_Start = boost::chrono::high_resolution_clock::now();
+			m_Nav.ComputeDistanceLayers(in_Sources, l_SimdLayers);
+			l_SimdTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+
+			l_Start = boost::chrono::high_resolution_clock::now();
+			for(auto l_It = in_Sources.begin(); l_It != in_Sources.end(); ++l_It)
+				m_Nav.Dijkstra(m_Nav.BaseNode(*l_It), m_Nav.m_Grid.Whole(), m_Nav.m_FlatContext, m_Nav.m_FlatStatistics);
+			l_SearchTimes.push_back(boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count());
+		}
+
+		bool l_Success = l_ScalarLayers.size() == in_Sources.size() && l_SimdLayers == l_ScalarLayers;
+		for(unsigned i = 0; l_Success && i < in_Sources.size(); ++i)
+		{
+			l_Success = l_ScalarLayers[i] == StepDistances(in_Level, in_Length, in_Width, in_Sources[i]);
+			m_Nav.Dijkstra(m_Nav.BaseNode(in_Sources[i]), m_Nav.m_Grid.Whole(), m_Nav.m_FlatContext, m_Nav.m_FlatStatistics);
+			for(unsigned l_Cell = 0; l_Success && l_Cell < l_ScalarLayers[i].size(); ++l_Cell)
+				l_Success = m_Nav.m_FlatContext.Closed(l_Cell) == (l_ScalarLayers[i][l_Cell] != Wavefront::M_UNREACHED);
+		}
+
+		m_Nav.Reset();
+		out_ScalarTime = ComputeMean(l_ScalarTimes);
+		out_SimdTime = ComputeMean(l_SimdTimes);
+		out_SearchTime = ComputeMean(l_SearchTimes);
+		return l_Success;
+	}
+
+	// Inits the level twice with the cache in the current directory, the second Init must load what the first one saved.
+	// Several navigators build the same level at once, like commanders started together. Every one must save the level or
+	// load it, and the file left must then be loaded by another navigator. The file written is removed.
+	bool ConcurrentSavesShareOneCache(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width, 
+		const unsigned in_NbNavigators)
+	{
+		std::vector<std::unique_ptr<Navigator>> l_Navigators;
+		boost::thread_group l_Threads;
+		for(unsigned i = 0; i < in_NbNavigators; ++i)
+		{
+			l_Navigators.push_back(std::unique_ptr<Navigator>(new Navigator()));
+			Navigator * l_Navigator = l_Navigators.back().get();
+			l_Navigator->SetCacheDirectory(".");
+			l_Navigator->SetWorkerCount(1);
+			l_Threads.create_thread([l_Navigator, &in_Level, in_Length, in_Width]() { l_Navigator->Init(in_Level, in_Length, in_Width); });
+		}
+		l_Threads.join_all();
+
+		bool l_Success = true;
+		for(auto l_It = l_Navigators.begin(); l_It != l_Navigators.end(); ++l_It)
+			l_Success = l_Success && ((*l_It)->IsSavedToCache() || (*l_It)->IsLoadedFromCache());
+
+		m_Nav.SetCacheDirectory(".");
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		l_Success = l_Success && m_Nav.IsLoadedFromCache();
+		std::remove(m_Nav.m_CachePath.c_str());
+		m_Nav.Reset();
+		m_Nav.SetCacheDirectory("");
+		return l_Success;
+	}
+
+	// A changed level, a changed number of landmarks or a truncated file must be preprocessed again, and nothing is saved
+	// in a missing directory. The files written are removed.
+	bool CacheMatchesPreprocessing(const std::unique_ptr<float[]> & in_Level, const int in_Length, const int in_Width,
+		double & out_InitTime, double & out_LoadTime)
+	{
+		const std::vector<Vector2> l_Positions(RandomWalkablePositions(in_Level, in_Length, in_Width, 2));
+		m_Nav.SetCacheDirectory(".");
+
+		boost::chrono::high_resolution_clock::time_point l_Start = boost::chrono::high_resolution_clock::now();
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		out_InitTime = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count();
+		const std::string l_CachePath = m_Nav.m_CachePath;
+		bool l_Success = !m_Nav.IsLoadedFromCache() && m_Nav.IsSavedToCache() && !m_Nav.m_Clusters[1][0].EntranceDistances.IsView();
+		// The searches run by Init are not part of the cache
+		std::vector<double> l_Expected(PreprocessingResult());
+		l_Expected.erase(l_Expected.begin() + 1, l_Expected.begin() + 3);
+		const Navigator::NodeVector l_ExpectedPath(m_Nav.ComputeAbstractPath(l_Positions[0], l_Positions[1]));
+		m_Nav.Reset();
+
+		l_Start = boost::chrono::high_resolution_clock::now();
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		out_LoadTime = boost::chrono::duration<double, boost::milli>(boost::chrono::high_resolution_clock::now() - l_Start).count();
+		std::vector<double> l_Result(PreprocessingResult());
+		l_Result.erase(l_Result.begin() + 1, l_Result.begin() + 3);
+		l_Success = l_Success && m_Nav.IsLoadedFromCache() && !m_Nav.IsSavedToCache() && l_Result == l_Expected 
+			&& m_Nav.ComputeAbstractPath(l_Positions[0], l_Positions[1]) == l_ExpectedPath;
+		// The large tables are read from the mapping of the file
+		l_Success = l_Success && m_Nav.m_Clusters[1][0].EntranceDistances.IsView() 
+			&& (m_Nav.m_DistanceTable.empty() || m_Nav.m_DistanceTable.IsView()) && (m_Nav.m_Landmarks.Empty() || m_Nav.m_Landmarks.Distances().IsView());
+		m_Nav.Reset();
+
+		std::unique_ptr<float[]> l_Changed(new float[in_Length * in_Width]);
+		std::copy(in_Level.get(), in_Level.get() + in_Length * in_Width, l_Changed.get());
+		l_Changed[0] = l_Changed[0] ? 0.f : 1.f;
+		m_Nav.Init(l_Changed, in_Length, in_Width);
+		l_Success = l_Success && !m_Nav.IsLoadedFromCache() && m_Nav.m_CachePath != l_CachePath;
+		std::remove(m_Nav.m_CachePath.c_str());
+		m_Nav.Reset();
+
+		m_Nav.SetLandmarkCount(2);
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		l_Success = l_Success && !m_Nav.IsLoadedFromCache() && m_Nav.GetLandmarkCount() == 2 && m_Nav.m_CachePath != l_CachePath;
+		std::remove(m_Nav.m_CachePath.c_str());
+		m_Nav.Reset();
+		m_Nav.SetLandmarkCount(8);
+
+		std::string l_Content(ReadAllFile(l_CachePath));
+		std::ofstream(l_CachePath, std::ios::out | std::ios::binary).write(l_Content.data(), l_Content.size() / 2);
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		l_Result = PreprocessingResult();
+		l_Result.erase(l_Result.begin() + 1, l_Result.begin() + 3);
+		l_Success = l_Success && !m_Nav.IsLoadedFromCache() && m_Nav.IsSavedToCache() && l_Result == l_Expected;
+		m_Nav.Reset();
+
+		m_Nav.SetCacheDirectory("MissingNavigationCache");
+		m_Nav.Init(in_Level, in_Length, in_Width);
+		l_Success = l_Success && !m_Nav.IsLoadedFromCache() && !m_Nav.IsSavedToCache();
+		m_Nav.Reset();
+
+		std::remove(l_CachePath.c_str());
+		m_Nav.SetCacheDirectory("");
+		return l_Success;
+	}
 };
 
 const double NavigationFixture::MAX_SEARCH_TIME = 80.0;
 const double NavigationFixture::MAX_INIT_TIME = 7500.0;
+const double NavigationFixture::MIN_EXPANSIONS_PER_MS = 500.0;
+const double NavigationFixture::MAX_LATENCY_DRIFT = 2.0;
+const double NavigationFixture::MAX_QUERY_OVERHEAD = 0.02;
+const double NavigationFixture::MAX_HIERARCHY_OVERCOST = 1.05;
+const double NavigationFixture::MAX_BACKGROUND_INIT_RATIO = 0.25;
+const double NavigationFixture::MAX_CACHE_LOAD_RATIO = 0.25;
 
 #endif // NAVIGATION_FIXTURE_H
@@ -22,27 +22,26 @@ BOOST_FIXTURE_TEST_SUITE( NavigationTestSuite, NavigationFixture )
 
 BOOST_AUTO_TEST_CASE( PathCorrectnessTest )
 {
-	std::vector<std::shared_ptr<Navigator::Node>> l_ExpectedAbstractPath;
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(0.f, 6.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(2.f, 4.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(2.f, 3.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(3.f, 3.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(4.f, 3.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(4.f, 4.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(7.f, 4.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(7.f, 3.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(4.f, 1.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(3.f, 1.f))));
-	l_ExpectedAbstractPath.push_back(std::make_shared<Navigator::Node>(Navigator::Node(1, 0, Vector2(1.f, 1.f))));
+	// The abstract path is the cheapest one on the abstract graph (cost of 17.94)
+	// The start and the goal are not entrances so they are represented by their base node
+	std::vector<Navigator::Node> l_ExpectedAbstractPath;
+	l_ExpectedAbstractPath.push_back(Navigator::Node(0, 0, Vector2(0.f, 6.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(1, 0, Vector2(3.f, 6.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(1, 0, Vector2(4.f, 6.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(1, 0, Vector2(7.f, 4.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(1, 0, Vector2(7.f, 3.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(1, 0, Vector2(4.f, 1.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(1, 0, Vector2(3.f, 1.f)));
+	l_ExpectedAbstractPath.push_back(Navigator::Node(0, 0, Vector2(1.f, 1.f)));
 
 	std::vector<Vector2> l_ExpectedConcretePath;
 	l_ExpectedConcretePath.push_back(Vector2(0.f, 6.f));
 	l_ExpectedConcretePath.push_back(Vector2(1.f, 5.f));
 	l_ExpectedConcretePath.push_back(Vector2(2.f, 4.f));
-	l_ExpectedConcretePath.push_back(Vector2(2.f, 3.f));
-	l_ExpectedConcretePath.push_back(Vector2(3.f, 3.f));
-	l_ExpectedConcretePath.push_back(Vector2(4.f, 4.f));
-	l_ExpectedConcretePath.push_back(Vector2(5.f, 5.f));
+	l_ExpectedConcretePath.push_back(Vector2(3.f, 5.f));
+	l_ExpectedConcretePath.push_back(Vector2(3.f, 6.f));
+	l_ExpectedConcretePath.push_back(Vector2(4.f, 6.f));
+	l_ExpectedConcretePath.push_back(Vector2(5.f, 6.f));
 	l_ExpectedConcretePath.push_back(Vector2(6.f, 5.f));
 	l_ExpectedConcretePath.push_back(Vector2(7.f, 4.f));
 	l_ExpectedConcretePath.push_back(Vector2(7.f, 3.f));
@@ -55,11 +54,11 @@ BOOST_AUTO_TEST_CASE( PathCorrectnessTest )
 
 	m_Nav.Init(m_SmallLevel->blockHeights, m_SmallLevel->height, m_SmallLevel->width, 4);
 
-	std::vector<std::shared_ptr<Navigator::Node>> l_AbstractPath(m_Nav.ComputeAbstractPath(m_StartPos, 
+	Navigator::NodeVector l_AbstractPath(m_Nav.ComputeAbstractPath(m_StartPos, 
 		m_GoalPos));
 	BOOST_REQUIRE(l_AbstractPath.size() == l_ExpectedAbstractPath.size());
 	for(unsigned i = 0; i < l_AbstractPath.size(); ++i)
-		BOOST_REQUIRE(*l_AbstractPath[i] == *l_ExpectedAbstractPath[i]);
+		BOOST_REQUIRE(m_Nav.GetNode(l_AbstractPath[i]) == l_ExpectedAbstractPath[i]);
 
 	std::vector<Vector2> l_ConcretePath;
 	for(unsigned i = 0; i < l_AbstractPath.size()-1; ++i)
@@ -111,4 +110,388 @@ BOOST_AUTO_TEST_CASE( NormalGraphPerformanceTest )
 	BOOST_REQUIRE(TestPerformance(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, false));
 }
 
+// Once Init has sized the search context, the searches must not touch the heap anymore
+BOOST_AUTO_TEST_CASE( SearchAllocationTest )
+{
+	m_Nav.Init(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width);
+	BOOST_REQUIRE(m_Nav.GetSearchStatistics().Searches > 0);
+
+	unsigned long long l_NbSearches = m_Nav.GetSearchStatistics().Searches;
+	BOOST_REQUIRE(CountSearchAllocations() == 0);
+	BOOST_REQUIRE(m_Nav.GetSearchStatistics().Searches > l_NbSearches);
+}
+
+BOOST_AUTO_TEST_CASE( EntranceDistancesTest )
+{
+	m_Nav.Init(m_SmallLevel->blockHeights, m_SmallLevel->height, m_SmallLevel->width, 4);
+	BOOST_REQUIRE(EntranceDistancesMatchSearches());
+	m_Nav.Reset();
+
+	m_Nav.Init(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width);
+	BOOST_REQUIRE(EntranceDistancesMatchSearches());
+}
+
+BOOST_AUTO_TEST_CASE( SmallExpansionThroughputTest )
+{
+	BOOST_REQUIRE(MeasureExpansionThroughput(m_SmallLevel->blockHeights, m_SmallLevel->height, m_SmallLevel->width, 
+		"Small Expansion Perf.txt", 4) > MIN_EXPANSIONS_PER_MS);
+}
+
+BOOST_AUTO_TEST_CASE( NormalExpansionThroughputTest )
+{
+	BOOST_REQUIRE(MeasureExpansionThroughput(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 
+		"Normal Expansion Perf.txt") > MIN_EXPANSIONS_PER_MS);
+}
+
+// Queries must not leave anything behind, otherwise every new bot position would slow down the following ones
+BOOST_AUTO_TEST_CASE( LongRunQueryTest )
+{
+	m_Nav.Init(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width);
+
+	std::vector<double> l_BatchTimes;
+	BOOST_REQUIRE(QueriesKeepGraphFlat(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 10, 500, l_BatchTimes));
+	BOOST_REQUIRE(l_BatchTimes.back() < MAX_LATENCY_DRIFT * l_BatchTimes.front());
+}
+
+// A 400x400 level is cut in 400 clusters, finding the ones of a query must not depend on their number
+BOOST_AUTO_TEST_CASE( ManyClustersQueryOverheadTest )
+{
+	std::unique_ptr<float[]> l_Level(MakePillarLevel(400, 400));
+	m_Nav.Init(l_Level, 400, 400);
+
+	BOOST_REQUIRE(MeasureQueryOverhead(l_Level, 400, 400, 200, "Query Overhead Perf.txt") < MAX_QUERY_OVERHEAD);
+}
+
+BOOST_AUTO_TEST_CASE( JumpPointSearchTest )
+{
+	BOOST_REQUIRE(JumpPointSearchMatchesGridAStar(m_SmallLevel->blockHeights, m_SmallLevel->height, m_SmallLevel->width, 
+		"Small Cluster Search Perf.txt", 4));
+	BOOST_REQUIRE(JumpPointSearchMatchesGridAStar(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 
+		"Normal Cluster Search Perf.txt"));
+}
+
+// Large levels get more abstract levels, their paths must stay close to the ones found with a single abstract level
+BOOST_AUTO_TEST_CASE( HierarchyDepthTest )
+{
+	m_Nav.Init(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width);
+	BOOST_REQUIRE(m_Nav.GetDepth() == 1);
+	m_Nav.Reset();
+
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	int l_FlatDepth = 0, l_Depth = 0;
+	double l_FlatTime = 0.0, l_Time = 0.0;
+	const double l_FlatCost = MeasureAbstractPaths(l_Level, 400, 704, 1, 50, l_FlatDepth, l_FlatTime);
+	const double l_Cost = MeasureAbstractPaths(l_Level, 400, 704, 0, 50, l_Depth, l_Time);
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Hierarchy Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Depth:" << l_FlatDepth << " Duration: " << l_FlatTime << " Cost: " << l_FlatCost << std::endl;
+		l_FileStream << "Depth:" << l_Depth << " Duration: " << l_Time << " Cost: " << l_Cost << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_FlatDepth == 1);
+	BOOST_REQUIRE(l_Depth > 1);
+	BOOST_REQUIRE(l_FlatCost > 0.0);
+	BOOST_REQUIRE(l_Cost > 0.0 && l_Cost < MAX_HIERARCHY_OVERCOST * l_FlatCost);
+}
+
+// The bidirectional search must find paths as short as the forward one between the flags of the medium level, the ones of map00
+// and the corners of a large level searched on its first abstract level only. It must expand fewer nodes between the corners.
+BOOST_AUTO_TEST_CASE( BidirectionalSearchTest )
+{
+	const Navigator::AbstractSearch l_Searches[] = { Navigator::ForwardSearch, Navigator::BidirectionalSearch };
+	std::vector<std::pair<Vector2, Vector2>> l_FlagQueries, l_CornerQueries;
+	l_FlagQueries.push_back(std::make_pair(Vector2(6.f, 30.f), Vector2(82.f, 20.f)));
+	l_FlagQueries.push_back(std::make_pair(Vector2(8.f, 27.f), Vector2(80.f, 23.f)));
+	l_CornerQueries.push_back(std::make_pair(Vector2(1.f, 1.f), Vector2(702.f, 398.f)));
+	l_CornerQueries.push_back(std::make_pair(Vector2(702.f, 1.f), Vector2(1.f, 398.f)));
+	std::unique_ptr<float[]> l_Rooms(MakeRoomsLevel(400, 704));
+
+	std::vector<double> l_FlagCosts[2], l_CornerCosts[2];
+	unsigned long long l_FlagExpansions[2], l_CornerExpansions[2];
+	double l_FlagTimes[2], l_CornerTimes[2];
+	for(int i = 0; i < 2; ++i)
+	{
+		BenchmarkAbstractSearch(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 0, l_FlagQueries, l_Searches[i], 
+			100, l_FlagCosts[i], l_FlagExpansions[i], l_FlagTimes[i]);
+		BenchmarkAbstractSearch(l_Rooms, 400, 704, 1, l_CornerQueries, l_Searches[i], 20, l_CornerCosts[i], l_CornerExpansions[i], l_CornerTimes[i]);
+	}
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Bidirectional Search Perf.txt", std::ios::out | std::ios::binary);
+	const char * l_Names[] = { "Forward", "Bidirectional" };
+	if(l_FileStream.is_open())
+	{
+		for(int i = 0; i < 2; ++i)
+		{
+			l_FileStream << l_Names[i] << " Flags Duration: " << l_FlagTimes[i] << " Expansions: " << l_FlagExpansions[i] << std::endl;
+			l_FileStream << l_Names[i] << " Corners Duration: " << l_CornerTimes[i] << " Expansions: " << l_CornerExpansions[i] << std::endl;
+		}
+	}
+#endif
+
+	for(unsigned i = 0; i < l_FlagQueries.size(); ++i)
+		BOOST_REQUIRE(l_FlagCosts[0][i] > 0.0 && std::abs(l_FlagCosts[1][i] - l_FlagCosts[0][i]) < 1e-6);
+	for(unsigned i = 0; i < l_CornerQueries.size(); ++i)
+		BOOST_REQUIRE(l_CornerCosts[0][i] > 0.0 && std::abs(l_CornerCosts[1][i] - l_CornerCosts[0][i]) < 1e-6);
+	BOOST_REQUIRE(l_CornerExpansions[1] < l_CornerExpansions[0]);
+}
+
+// The workers share the clusters of Init, the Navigator they build must not depend on their number
+BOOST_AUTO_TEST_CASE( ParallelPreprocessTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	const unsigned l_NbWorkers[] = { 1, 2, 4, 0 };
+	std::vector<double> l_Times, l_Result, l_ExpectedResult;
+
+	for(unsigned i = 0; i < sizeof(l_NbWorkers) / sizeof(l_NbWorkers[0]); ++i)
+	{
+		l_Times.push_back(MeasureInit(l_Level, 400, 704, l_NbWorkers[i], i ? l_Result : l_ExpectedResult));
+		BOOST_REQUIRE(i == 0 || l_Result == l_ExpectedResult);
+	}
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Parallel Init Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		for(unsigned i = 0; i < l_Times.size(); ++i)
+			l_FileStream << "Workers:" << l_NbWorkers[i] << " Duration: " << l_Times[i] << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(!l_ExpectedResult.empty());
+}
+
+BOOST_AUTO_TEST_CASE( ClusterProcessingTest )
+{
+	BOOST_REQUIRE(ClusterProcessingMatchesSearches(m_SmallLevel->blockHeights, m_SmallLevel->height, m_SmallLevel->width, 
+		"Small Cluster Processing Perf.txt"));
+	BOOST_REQUIRE(ClusterProcessingMatchesSearches(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 
+		"Normal Cluster Processing Perf.txt"));
+}
+
+// The searches specialised on the size of the clusters must find the same paths as the generic Dijkstra, in less time
+BOOST_AUTO_TEST_CASE( ClusterSearchTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(80, 80));
+	double l_GenericTime = 0.0, l_SpecialisedTime = 0.0, l_MediumGenericTime = 0.0, l_MediumSpecialisedTime = 0.0;
+	BOOST_REQUIRE(ClusterSearchMatchesDijkstra(l_Level, 80, 80, l_GenericTime, l_SpecialisedTime));
+	BOOST_REQUIRE(ClusterSearchMatchesDijkstra(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 
+		l_MediumGenericTime, l_MediumSpecialisedTime));
+	BOOST_REQUIRE(FourConnectedSearchIsManhattan());
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Cluster Search Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Rooms Generic Duration: " << l_GenericTime << " Specialised Duration: " << l_SpecialisedTime << std::endl;
+		l_FileStream << "Normal Generic Duration: " << l_MediumGenericTime << " Specialised Duration: " << l_MediumSpecialisedTime << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_SpecialisedTime < l_GenericTime);
+}
+
+// Loading the level must be much faster than building the hierarchy, the queries are answered on the flat grid meanwhile
+BOOST_AUTO_TEST_CASE( BackgroundInitTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	unsigned l_NbFlatQueries = 0;
+	double l_InitTime = 0.0, l_BackgroundInitTime = 0.0;
+	BOOST_REQUIRE(FlatPathsUntilHierarchyReady(l_Level, 400, 704, 50, l_NbFlatQueries, l_InitTime, l_BackgroundInitTime));
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Background Init Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Init Duration: " << l_InitTime << std::endl;
+		l_FileStream << "Background Init Duration: " << l_BackgroundInitTime << " Flat Queries: " << l_NbFlatQueries << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_BackgroundInitTime < MAX_BACKGROUND_INIT_RATIO * l_InitTime);
+}
+
+// Reset must stop the preprocessing workers safely while the hierarchy is still being built
+BOOST_AUTO_TEST_CASE( BackgroundResetTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	BOOST_REQUIRE(ResetDuringBackgroundInit(l_Level, 400, 704, 4));
+}
+
+BOOST_AUTO_TEST_CASE( DistanceOracleTest )
+{
+	double l_DistanceTime = 0.0, l_PathTime = 0.0;
+	BOOST_REQUIRE(DistancesMatchPaths(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 200, 
+		l_DistanceTime, l_PathTime));
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Distance Oracle Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Distance Duration: " << l_DistanceTime << std::endl;
+		l_FileStream << "Abstract Path Duration: " << l_PathTime << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_DistanceTime < l_PathTime);
+}
+
+// The landmarks must not change the cost of the paths and must expand fewer nodes than the other admissible heuristics in a maze
+BOOST_AUTO_TEST_CASE( LandmarkHeuristicTest )
+{
+	std::unique_ptr<float[]> l_Maze(MakeMazeLevel(240, 240));
+	std::vector<HeuristicBenchmark> l_Grid, l_Abstract, l_RoomsGrid, l_RoomsAbstract;
+	BenchmarkHeuristics(l_Maze, 240, 240, 100, l_Grid, l_Abstract);
+	std::unique_ptr<float[]> l_Rooms(MakeRoomsLevel(400, 704));
+	BenchmarkHeuristics(l_Rooms, 400, 704, 50, l_RoomsGrid, l_RoomsAbstract);
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Landmark Heuristic Perf.txt", std::ios::out | std::ios::binary);
+	const char * l_Names[] = { "Trivial", "Euclidean", "Manhattan", "Landmarks", "Octile", "Octile and Landmarks" };
+	if(l_FileStream.is_open())
+	{
+		for(unsigned i = 0; i < l_Grid.size(); ++i)
+		{
+			l_FileStream << l_Names[i] << " Maze Grid Duration: " << l_Grid[i].Duration << " Expansions: " << l_Grid[i].Expansions 
+				<< " Abstract Duration: " << l_Abstract[i].Duration << " Expansions: " << l_Abstract[i].Expansions << " Cost: " << l_Abstract[i].Cost << std::endl;
+			l_FileStream << l_Names[i] << " Rooms Grid Duration: " << l_RoomsGrid[i].Duration << " Expansions: " << l_RoomsGrid[i].Expansions 
+				<< " Abstract Duration: " << l_RoomsAbstract[i].Duration << " Expansions: " << l_RoomsAbstract[i].Expansions << " Cost: " << l_RoomsAbstract[i].Cost << std::endl;
+		}
+	}
+#endif
+
+	BOOST_REQUIRE(std::abs(l_Grid[3].Cost - l_Grid[0].Cost) < 1e-3 && std::abs(l_Abstract[3].Cost - l_Abstract[0].Cost) < 1e-3);
+	BOOST_REQUIRE(std::abs(l_RoomsGrid[3].Cost - l_RoomsGrid[0].Cost) < 1e-3 && std::abs(l_RoomsAbstract[3].Cost - l_RoomsAbstract[0].Cost) < 1e-3);
+	BOOST_REQUIRE(l_Grid[3].Expansions < l_Grid[1].Expansions && l_Abstract[3].Expansions < l_Abstract[1].Expansions);
+}
+
+// A heuristic must search the same way whether it is inlined or called through a virtual function, and the larger of octile
+// and landmarks must expand fewer nodes than octile alone
+BOOST_AUTO_TEST_CASE( HeuristicPolicyTest )
+{
+	const unsigned l_NbQueries = 100;
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	std::vector<HeuristicBenchmark> l_Results;
+	BenchmarkHeuristicDispatch(l_Level, 400, 704, l_NbQueries, l_Results);
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Heuristic Policy Perf.txt", std::ios::out | std::ios::binary);
+	const char * l_Names[] = { "Octile", "Virtual Octile", "Octile and Landmarks", "Virtual Octile and Landmarks" };
+	if(l_FileStream.is_open())
+	{
+		for(unsigned i = 0; i < l_Results.size(); ++i)
+			l_FileStream << l_Names[i] << " Duration: " << l_Results[i].Duration << " Expansions: " << l_Results[i].Expansions 
+				<< " Nanoseconds per Expansion: " << l_Results[i].Duration * l_NbQueries * 1e6 / l_Results[i].Expansions << std::endl;
+	}
+#endif
+
+	for(unsigned i = 0; i < l_Results.size(); i += 2)
+		BOOST_REQUIRE(l_Results[i].Expansions == l_Results[i+1].Expansions && std::abs(l_Results[i].Cost - l_Results[i+1].Cost) < 1e-6);
+	BOOST_REQUIRE(std::abs(l_Results[2].Cost - l_Results[0].Cost) < 1e-3 && l_Results[2].Expansions < l_Results[0].Expansions);
+}
+
+// The positions inside a walled box, or on its walls, cannot be reached from the rest of the level
+BOOST_AUTO_TEST_CASE( ComponentsTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	AddWalledBox(l_Level, 704, 164, 104, 8);
+	std::vector<Vector2> l_Pocket;
+	for(int i = 0; i < 8; ++i)
+		l_Pocket.push_back(Vector2(static_cast<float>(164 + i), static_cast<float>(104 + i)));
+	for(int i = 1; i < 7; ++i)
+		l_Pocket.push_back(Vector2(static_cast<float>(165 + i % 6), static_cast<float>(104 + i)));
+	double l_RejectTime = 0.0, l_SearchTime = 0.0;
+	BOOST_REQUIRE(ReachabilityMatchesSearches(l_Level, 400, 704, l_Pocket, 100, l_RejectTime, l_SearchTime));
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Components Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Rejected Query Duration: " << l_RejectTime << std::endl;
+		l_FileStream << "Exhaustive Search Duration: " << l_SearchTime << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_RejectTime < l_SearchTime);
+}
+
+// The entrances of the upper clusters are in different clusters of the first level, their edges must all be kept
+BOOST_AUTO_TEST_CASE( UpperGraphTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	unsigned l_NbPairs = 0;
+	BOOST_REQUIRE(UpperEdgesMatchEntranceDistances(l_Level, 400, 704, 2, l_NbPairs));
+	BOOST_REQUIRE(l_NbPairs > 0);
+}
+
+// The fixed goals of a match are reached by following their flow fields, the last goal is inside a walled box
+BOOST_AUTO_TEST_CASE( FlowFieldTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	AddWalledBox(l_Level, 704, 164, 104, 8);
+	std::vector<Vector2> l_Goals;
+	l_Goals.push_back(Vector2(1.f, 1.f));
+	l_Goals.push_back(Vector2(702.f, 398.f));
+	l_Goals.push_back(Vector2(350.f, 200.f));
+	l_Goals.push_back(Vector2(167.f, 107.f));
+	double l_FlowTime = 0.0, l_PathTime = 0.0;
+	BOOST_REQUIRE(FlowPathsMatchSearches(l_Level, 400, 704, l_Goals, 100, l_FlowTime, l_PathTime));
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Flow Field Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Flow Path Duration: " << l_FlowTime << std::endl;
+		l_FileStream << "Refined Abstract Path Duration: " << l_PathTime << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_FlowTime < l_PathTime);
+}
+
+// The distance layers of the ten bots and the two flags must be cheaper than a search from each of them
+BOOST_AUTO_TEST_CASE( WavefrontTest )
+{
+	const std::vector<Vector2> l_Sources(RandomWalkablePositions(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, 12));
+	double l_ScalarTime = 0.0, l_SimdTime = 0.0, l_SearchTime = 0.0;
+	BOOST_REQUIRE(BenchmarkWavefront(m_MediumLevel->blockHeights, m_MediumLevel->height, m_MediumLevel->width, l_Sources, 50, 
+		l_ScalarTime, l_SimdTime, l_SearchTime));
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Wavefront Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Scalar Wavefront Duration: " << l_ScalarTime << std::endl;
+		l_FileStream << "SIMD Wavefront Duration: " << l_SimdTime << std::endl;
+		l_FileStream << "Searches Duration: " << l_SearchTime << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_ScalarTime < l_SearchTime && l_SimdTime < l_SearchTime);
+}
+
+// The second Init of a level maps what the first one saved instead of preprocessing it again
+BOOST_AUTO_TEST_CASE( NavigationCacheTest )
+{
+	std::unique_ptr<float[]> l_Level(MakeRoomsLevel(400, 704));
+	double l_InitTime = 0.0, l_LoadTime = 0.0;
+	BOOST_REQUIRE(CacheMatchesPreprocessing(l_Level, 400, 704, l_InitTime, l_LoadTime));
+	BOOST_REQUIRE(ConcurrentSavesShareOneCache(l_Level, 400, 704, 4));
+
+#ifdef _LOG_PERF
+	std::ofstream l_FileStream("Navigation Cache Perf.txt", std::ios::out | std::ios::binary);
+	if(l_FileStream.is_open())
+	{
+		l_FileStream << "Init Duration: " << l_InitTime << std::endl;
+		l_FileStream << "Cache Load Duration: " << l_LoadTime << std::endl;
+	}
+#endif
+
+	BOOST_REQUIRE(l_LoadTime < MAX_CACHE_LOAD_RATIO * l_InitTime);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+#ifdef STAND_ALONE
+#   define BOOST_TEST_MODULE Main
+#endif
+#include <boost/test/unit_test.hpp>
+
+#include "EncodedPath.h"
+#include "PathCache.h"
+
+/*
+* Author : Felix-Antoine Ouellet
+* CIP :	   09 137 551
+*
+* Path Cache Tests
+* The goal of these tests is to make sure that the path cache stays within its budget
+* and evicts the least recently used paths first, and that encoded paths decode to the cells they were built from
+*/
+BOOST_AUTO_TEST_SUITE( PathCacheTestSuite )
+
+typedef PathCache<std::vector<std::uint32_t>> NodePathCache;
+
+NodePathCache::Path MakePath(const NodePathCache::NodeId in_Start, const NodePathCache::NodeId in_Goal)
+{
+	NodePathCache::Path l_Path;
+	l_Path.push_back(in_Start);
+	l_Path.push_back(100);
+	l_Path.push_back(in_Goal);
+	return l_Path;
+}
+
+BOOST_AUTO_TEST_CASE( FindTest )
+{
+	NodePathCache l_Cache;
+	bool l_Reversed = false;
+
+	BOOST_REQUIRE(l_Cache.Find(1, 2, l_Reversed) == nullptr);
+	BOOST_REQUIRE(l_Cache.Size() == 0);
+
+	l_Cache.Store(1, 2, MakePath(1, 2));
+	const NodePathCache::Path * l_Path = l_Cache.Find(1, 2, l_Reversed);
+	BOOST_REQUIRE(l_Path != nullptr);
+	BOOST_REQUIRE(!l_Reversed);
+	BOOST_REQUIRE(*l_Path == MakePath(1, 2));
+
+	// Both directions share the same entry
+	l_Path = l_Cache.Find(2, 1, l_Reversed);
+	BOOST_REQUIRE(l_Path != nullptr);
+	BOOST_REQUIRE(l_Reversed);
+	BOOST_REQUIRE(*l_Path == MakePath(1, 2));
+
+	l_Cache.Store(4, 3, MakePath(4, 3));
+	l_Path = l_Cache.Find(3, 4, l_Reversed);
+	BOOST_REQUIRE(l_Path != nullptr);
+	BOOST_REQUIRE(l_Reversed);
+	BOOST_REQUIRE(NodePathCache::Path(l_Path->rbegin(), l_Path->rend()) == MakePath(3, 4));
+
+	BOOST_REQUIRE(l_Cache.Size() == 2);
+	BOOST_REQUIRE(l_Cache.GetStatistics().Hits == 3);
+	BOOST_REQUIRE(l_Cache.GetStatistics().Misses == 1);
+}
+
+BOOST_AUTO_TEST_CASE( EvictionTest )
+{
+	NodePathCache l_Cache;
+	l_Cache.Store(0, 1, MakePath(0, 1));
+	const std::size_t l_EntrySize = l_Cache.Bytes();
+	l_Cache.SetBudget(3 * l_EntrySize);
+
+	l_Cache.Store(0, 2, MakePath(0, 2));
+	l_Cache.Store(0, 3, MakePath(0, 3));
+
+	// Using the oldest path makes the second one the least recently used
+	bool l_Reversed = false;
+	BOOST_REQUIRE(l_Cache.Find(0, 1, l_Reversed) != nullptr);
+	l_Cache.Store(0, 4, MakePath(0, 4));
+
+	BOOST_REQUIRE(l_Cache.Bytes() <= l_Cache.Budget());
+	BOOST_REQUIRE(l_Cache.Size() == 3);
+	BOOST_REQUIRE(l_Cache.GetStatistics().Evictions == 1);
+	BOOST_REQUIRE(l_Cache.Find(0, 2, l_Reversed) == nullptr);
+	BOOST_REQUIRE(l_Cache.Find(0, 1, l_Reversed) != nullptr);
+	BOOST_REQUIRE(l_Cache.Find(0, 3, l_Reversed) != nullptr);
+	BOOST_REQUIRE(l_Cache.Find(0, 4, l_Reversed) != nullptr);
+
+	// A path bigger than the whole budget is never stored
+	l_Cache.Store(5, 6, NodePathCache::Path(l_EntrySize * 3, 5));
+	BOOST_REQUIRE(l_Cache.Size() == 3);
+
+	l_Cache.SetBudget(l_EntrySize);
+	BOOST_REQUIRE(l_Cache.Size() == 1);
+	BOOST_REQUIRE(l_Cache.GetStatistics().Evictions == 3);
+}
+
+BOOST_AUTO_TEST_CASE( EncodedPathTest )
+{
+	// All eight directions, and enough steps to spill over a second word
+	const int l_Cells[][2] = { { 5, 5 }, { 6, 5 }, { 7, 6 }, { 7, 7 }, { 6, 8 }, { 5, 8 }, { 4, 7 }, { 4, 6 }, { 5, 5 } };
+	const unsigned l_NbCells = sizeof(l_Cells) / sizeof(l_Cells[0]);
+
+	std::vector<Vector2> l_Expected;
+	EncodedPath l_Path(l_Cells[0][0], l_Cells[0][1]);
+	l_Expected.push_back(Vector2(static_cast<float>(l_Cells[0][0]), static_cast<float>(l_Cells[0][1])));
+	for(unsigned i = 0; i < 3; ++i)
+		for(unsigned j = 1; j < l_NbCells; ++j)
+		{
+			l_Path.Append(l_Cells[j][0], l_Cells[j][1]);
+			l_Expected.push_back(Vector2(static_cast<float>(l_Cells[j][0]), static_cast<float>(l_Cells[j][1])));
+		}
+	BOOST_REQUIRE(l_Path.NbSteps() == 3 * (l_NbCells - 1));
+
+	std::vector<Vector2> l_Decoded;
+	l_Path.Decode(false, l_Decoded);
+	BOOST_REQUIRE(l_Decoded == l_Expected);
+
+	l_Decoded.clear();
+	l_Path.Decode(true, l_Decoded);
+	BOOST_REQUIRE(l_Decoded == std::vector<Vector2>(l_Expected.rbegin(), l_Expected.rend()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()